@@ -0,0 +1,47 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <iterator>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	float x;
+	float y;
+};
+}
+
+TEST_CASE("Scanning every component vs only the changed ones", "[bench][change_tracking]") {
+	using namespace ecs;
+	registry reg;
+	reg.track<position>();
+	std::vector<entity_t> ents;
+	reg.create_many(1000000, std::back_inserter(ents));
+	reg.insert<position>(ents.begin(), ents.end(), position{ 0.f, 0.f });
+	uint64_t since = reg.advance_tick();
+	// a mostly static world: 100 entities moved, clustered like objects in one area
+	for (size_t i = 500000; i < 500100; ++i) {
+		ents[i]->patch<position>([](position& p) {
+			p.x += 1.f;
+		});
+	}
+	const registry& cr = reg;
+
+	BENCHMARK("each, 1000000 entities") {
+		float sum = 0.f;
+		cr.view<position>().each([&sum](const position& p) {
+			sum += p.x;
+		});
+		return sum;
+	};
+
+	BENCHMARK("changed() each, 100 of 1000000 entities changed") {
+		float sum = 0.f;
+		cr.view<position>().changed<position>(since).each([&sum](const position& p) {
+			sum += p.x;
+		});
+		return sum;
+	};
+}
@@ -0,0 +1,41 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	float x;
+	float y;
+};
+
+/// removes and adds back random components of a pool filled to the given ratio of its cap
+void churn(const char* name, size_t cap, double fill) {
+	using namespace ecs;
+	registry reg(cap);
+	std::vector<entity_t> ents;
+	reg.create_many(cap, std::back_inserter(ents));
+	size_t filled = size_t(cap * fill);
+	reg.insert<position>(ents.begin(), ents.begin() + filled);
+	std::mt19937 rng(1337);
+	BENCHMARK(name) {
+		// remove a random component, then give it to a random entity without one
+		entity_t& victim = ents[rng() % filled];
+		victim->remove<position>();
+		std::swap(victim, ents[filled - 1]);
+		entity_t& heir = ents[filled - 1 + rng() % (cap - filled + 1)];
+		heir->add<position>(1.f, 1.f);
+		std::swap(heir, ents[filled - 1]);
+	};
+}
+}
+
+TEST_CASE("Add/remove churn at high fill ratios", "[bench][churn]") {
+	churn("churn, 10^6 slots, 50% full", 1000000, 0.5);
+	churn("churn, 10^6 slots, 99% full", 1000000, 0.99);
+	churn("churn, 10^6 slots, 100% full", 1000000, 1.0);
+	churn("churn, 4*10^6 slots, 99% full", 4000000, 0.99);
+}
@@ -0,0 +1,67 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <span>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	float x;
+	float y;
+};
+
+struct velocity {
+	float x;
+	float y;
+};
+
+/// the readme's movement system, over n entities
+void populate(ecs::registry& reg, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		auto e = reg.create();
+		e->add<position>(float(i), 0.f);
+		e->add<velocity>(1.f, 2.f);
+	}
+}
+}
+
+TEST_CASE("Per-entity vs chunked iteration", "[bench][iteration]") {
+	using namespace ecs;
+	registry reg;
+	populate(reg, 100000);
+
+	BENCHMARK("view::each") {
+		reg.view<position, velocity>().each([](position& p, const velocity& v) {
+			p.x += v.x;
+			p.y += v.y;
+		});
+	};
+
+	BENCHMARK("view::each_chunk") {
+		reg.view<position, velocity>().each_chunk([](std::span<position> ps, std::span<velocity> vs) {
+			for (size_t i = 0; i < ps.size(); ++i) {
+				ps[i].x += vs[i].x;
+				ps[i].y += vs[i].y;
+			}
+		});
+	};
+
+	auto g = reg.group<position, velocity>();
+
+	BENCHMARK("group::each") {
+		g.each([](position& p, const velocity& v) {
+			p.x += v.x;
+			p.y += v.y;
+		});
+	};
+
+	BENCHMARK("group::each_chunk") {
+		g.each_chunk([](std::span<position> ps, std::span<velocity> vs) {
+			for (size_t i = 0; i < ps.size(); ++i) {
+				ps[i].x += vs[i].x;
+				ps[i].y += vs[i].y;
+			}
+		});
+	};
+}
@@ -0,0 +1,56 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <iterator>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	float x;
+	float y;
+};
+
+struct velocity {
+	float x;
+	float y;
+};
+
+struct burning {
+	float heat;
+};
+}
+
+TEST_CASE("Walking a view vs a cached query", "[bench][query]") {
+	using namespace ecs;
+	registry reg;
+	std::vector<entity_t> ents;
+	reg.create_many(200000, std::back_inserter(ents));
+	// half of the entities move and half burn, but only a few do both
+	for (size_t i = 0; i < ents.size(); ++i) {
+		ents[i]->add<position>(float(i), 0.f);
+		if (i % 2 == 0) ents[i]->add<velocity>(1.f, 2.f);
+		if (i % 2 == 1 || i % 100 == 0) ents[i]->add<burning>(1.f);
+	}
+	auto q = reg.query<position, velocity, burning>();
+
+	BENCHMARK("view<position, velocity, burning>::each, 2000 of 200000 entities") {
+		reg.view<position, velocity, burning>().each([](position& p, const velocity& v, const burning& b) {
+			p.y += v.y * b.heat;
+		});
+	};
+
+	BENCHMARK("query<position, velocity, burning>::each, 2000 of 200000 entities") {
+		q.each([](position& p, const velocity& v, const burning& b) {
+			p.y += v.y * b.heat;
+		});
+	};
+
+	BENCHMARK("add and remove burning, with the query cached") {
+		for (size_t i = 2; i < 1000; i += 100) {
+			ents[i]->add<burning>(1.f);
+			ents[i]->remove<burning>();
+		}
+	};
+}
@@ -0,0 +1,61 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <iterator>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	float x;
+	float y;
+};
+
+struct velocity {
+	float x;
+	float y;
+};
+
+struct mass {
+	float value;
+};
+
+struct frozen {
+	bool yes;
+};
+}
+
+TEST_CASE("Matching entities on several components", "[bench][signatures]") {
+	using namespace ecs;
+	registry reg;
+	std::vector<entity_t> ents;
+	reg.create_many(200000, std::back_inserter(ents));
+	// every entity moves, some are missing a component, a few are frozen
+	for (size_t i = 0; i < ents.size(); ++i) {
+		ents[i]->add<position>(float(i), 0.f);
+		if (i % 2) ents[i]->add<velocity>(1.f, 2.f);
+		if (i % 3) ents[i]->add<mass>(1.f);
+		if (i % 5 == 0) ents[i]->add<frozen>(true);
+	}
+
+	BENCHMARK("view<position, velocity, mass>::each") {
+		reg.view<position, velocity, mass>().each([](position& p, const velocity& v, const mass& m) {
+			p.x += v.x * m.value;
+		});
+	};
+
+	BENCHMARK("view<position, velocity, mass, exclude<frozen>>::each") {
+		reg.view<position, velocity, mass, exclude<frozen>>().each([](position& p, const velocity& v, const mass& m) {
+			p.x += v.x * m.value;
+		});
+	};
+
+	BENCHMARK("view<position, velocity, mass> iterator") {
+		float sum = 0.f;
+		for (auto [p, v, m] : reg.view<position, velocity, mass>()) {
+			sum += p.x;
+		}
+		return sum;
+	};
+}
@@ -0,0 +1,59 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	float x;
+	float y;
+};
+
+struct velocity {
+	float x;
+	float y;
+};
+
+void register_types(ecs::registry& reg) {
+	reg.register_component<position>("position");
+	reg.register_component<velocity>("velocity");
+}
+}
+
+TEST_CASE("Building a world vs loading a snapshot", "[bench][snapshot]") {
+	using namespace ecs;
+	const std::string path = "ecs-bench-snapshot.bin";
+	{
+		registry reg;
+		register_types(reg);
+		std::vector<entity_t> ents;
+		reg.create_many(1000000, std::back_inserter(ents));
+		reg.insert<position>(ents.begin(), ents.end(), position{ 0.f, 0.f });
+		reg.insert<velocity>(ents.begin(), ents.end(), velocity{ 1.f, 1.f });
+		reg.save(path);
+	}
+
+	BENCHMARK("create + add, 1000000 entities") {
+		registry reg;
+		for (int i = 0; i < 1000000; ++i) {
+			auto e = reg.create();
+			e->add<position>(0.f, 0.f);
+			e->add<velocity>(1.f, 1.f);
+		}
+		return reg.count();
+	};
+
+	BENCHMARK("load_mapped, 1000000 entities") {
+		registry reg;
+		register_types(reg);
+		reg.load_mapped(path);
+		return reg.count();
+	};
+
+	std::remove(path.c_str());
+}
@@ -0,0 +1,55 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <span>
+
+#include <ecs.hpp>
+
+namespace {
+/// a wide physics component, of which a pass touches two fields
+struct rigid_body {
+	float px, py, pz;
+	float vx, vy, vz;
+	float mass, drag;
+};
+
+struct rigid_body_soa {
+	float px, py, pz;
+	float vx, vy, vz;
+	float mass, drag;
+};
+}
+
+template <>
+struct ecs::soa_layout<rigid_body_soa>
+	: ecs::soa_fields<&rigid_body_soa::px, &rigid_body_soa::py, &rigid_body_soa::pz,
+					  &rigid_body_soa::vx, &rigid_body_soa::vy, &rigid_body_soa::vz,
+					  &rigid_body_soa::mass, &rigid_body_soa::drag> {};
+
+TEST_CASE("Whole vs structure of arrays storage", "[bench][soa]") {
+	using namespace ecs;
+	registry reg;
+	for (int i = 0; i < 100000; ++i) {
+		auto e = reg.create();
+		e->add<rigid_body>(0.f, 0.f, 0.f, 1.f, 1.f, 1.f, 1.f, 0.f);
+		e->add<rigid_body_soa>(0.f, 0.f, 0.f, 1.f, 1.f, 1.f, 1.f, 0.f);
+	}
+
+	BENCHMARK("whole, each_chunk") {
+		reg.view<rigid_body>().each_chunk([](std::span<rigid_body> bs) {
+			for (rigid_body& b : bs) {
+				b.px += b.vx;
+			}
+		});
+	};
+
+	BENCHMARK("structure of arrays, each_chunk") {
+		reg.view<rigid_body_soa>().each_chunk([](soa_span<rigid_body_soa> bs) {
+			std::span<float> px		  = bs.get<&rigid_body_soa::px>();
+			std::span<const float> vx = bs.get<&rigid_body_soa::vx>();
+			for (size_t i = 0; i < px.size(); ++i) {
+				px[i] += vx[i];
+			}
+		});
+	};
+}
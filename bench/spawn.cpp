@@ -0,0 +1,43 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <iterator>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	float x;
+	float y;
+};
+
+struct velocity {
+	float x;
+	float y;
+};
+}
+
+TEST_CASE("Spawning one by one vs in bulk", "[bench][spawn]") {
+	using namespace ecs;
+
+	BENCHMARK("create + add, 50000 entities") {
+		registry reg;
+		for (int i = 0; i < 50000; ++i) {
+			auto e = reg.create();
+			e->add<position>(0.f, 0.f);
+			e->add<velocity>(1.f, 1.f);
+		}
+		return reg.count();
+	};
+
+	BENCHMARK("create_many + insert, 50000 entities") {
+		registry reg;
+		std::vector<entity_t> ents;
+		ents.reserve(50000);
+		reg.create_many(50000, std::back_inserter(ents));
+		reg.insert<position>(ents.begin(), ents.end(), position{ 0.f, 0.f });
+		reg.insert<velocity>(ents.begin(), ents.end(), velocity{ 1.f, 1.f });
+		return reg.count();
+	};
+}
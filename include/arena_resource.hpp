@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief a memory resource handing out memory from large chunks, to keep a registry's memory
+ * apart from the rest of the process, e.g. registry reg(component_pool::unlimited, &arena)
+ *
+ * @remarks freed blocks are kept for later allocations of the same size and alignment,
+ * and only returned to the system when the arena is destroyed.
+ * on linux, chunks are aligned to HUGE_PAGE_SZ and backed by transparent huge pages if asked,
+ * so walking large pools takes fewer TLB misses.
+ * thread safe
+ */
+class arena_resource : public std::pmr::memory_resource {
+public:
+	/// the size (in bytes) of a transparent huge page, the alignment of each chunk
+	static constexpr size_t HUGE_PAGE_SZ = 2 * 1024 * 1024;
+
+	/**
+	 * @brief constructor
+	 *
+	 * @param chunk_sz the size (in bytes) of each chunk, rounded up to HUGE_PAGE_SZ.
+	 * allocations over half a chunk get one of their own
+	 * @param huge_pages whether to ask the system to back the chunks with transparent huge pages
+	 */
+	arena_resource(size_t chunk_sz = 8 * HUGE_PAGE_SZ, bool huge_pages = true);
+	~arena_resource();
+
+	arena_resource(const arena_resource& other) = delete;
+	arena_resource(arena_resource&& other)		= delete;
+	arena_resource& operator=(const arena_resource& other) = delete;
+	arena_resource& operator=(arena_resource&& other) = delete;
+
+	/**
+	 * @return how many bytes are currently handed out
+	 */
+	size_t allocated() const;
+
+	/**
+	 * @return how many bytes the arena took from the system
+	 */
+	size_t reserved() const;
+
+private:
+	/// frees a chunk allocated with HUGE_PAGE_SZ alignment
+	struct chunk_deleter {
+		void operator()(char* chunk) const;
+	};
+
+	/// the size of each chunk
+	const size_t CHUNK_SZ;
+	/// whether to advise huge pages for each chunk
+	const bool HUGE_PAGES;
+
+	/// every chunk taken from the system
+	std::vector<std::unique_ptr<char[], chunk_deleter>> m_chunks;
+	/// how many bytes of the last regular chunk are used
+	size_t m_chunk_used;
+	/// the chunk bump allocations come from, or nullptr before the first
+	char* m_current;
+	/// freed blocks, by size and alignment
+	std::map<std::pair<size_t, size_t>, std::vector<void*>> m_free;
+	/// bytes currently handed out
+	size_t m_allocated;
+	/// bytes taken from the system
+	size_t m_reserved;
+	/// guards everything above
+	mutable std::mutex m_mtx;
+
+	void* do_allocate(size_t bytes, size_t align) override;
+	void do_deallocate(void* p, size_t bytes, size_t align) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	/// take a chunk of at least the given size from the system
+	char* new_chunk(size_t bytes);
+};
+
+}
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <internal/component_id.hpp>
+#include <internal/entity_id.hpp>
+
+#include <entity.hpp>
+#include <registry.hpp>
+
+namespace ecs {
+
+/**
+ * @brief records structural changes to a registry, to play them back later at once with flush(),
+ * e.g. from within a view's callback or a worker thread, where changing the registry directly is unsafe
+ *
+ * @remarks recording is not synchronized: use one buffer per thread, e.g. through a command_queue.
+ * on playback, components are added, replaced and removed one pool at a time,
+ * each component type in the order its commands were recorded, before destroying entities
+ */
+class command_buffer {
+public:
+	/**
+	 * @brief an entity the buffer will create on playback,
+	 * which commands of the same buffer can refer to before it exists
+	 */
+	struct placeholder {
+		/// the buffer that will create the entity
+		const command_buffer* owner;
+		/// the index of the entity among those the buffer creates
+		size_t index;
+	};
+
+	/**
+	 * @brief the entity a command applies to: either an existing one, or a placeholder
+	 */
+	class target {
+	public:
+		target(const entity_t& e);
+		target(placeholder p);
+
+	private:
+		friend class command_buffer;
+		/// the buffer owning the placeholder, or nullptr if this is an existing entity
+		const command_buffer* m_owner;
+		/// the id of the existing entity, or the index of the placeholder
+		size_t m_value;
+	};
+
+	command_buffer();
+	~command_buffer();
+
+	command_buffer(const command_buffer& other) = delete;
+	command_buffer(command_buffer&& other)		= delete;
+	command_buffer& operator=(const command_buffer& other) = delete;
+	command_buffer& operator=(command_buffer&& other) = delete;
+
+	/**
+	 * @brief record the creation of an entity
+	 *
+	 * @return a placeholder for the entity, usable as the target of this buffer's commands
+	 */
+	placeholder create();
+
+	/**
+	 * @brief record the removal of an entity and all its components.
+	 * does nothing if it is gone by then
+	 */
+	void destroy(target e);
+
+	/**
+	 * @brief record adding a component to an entity,
+	 * replacing the entity's component if it has one by then
+	 *
+	 * @param e the entity to add the component to
+	 * @param args the arguments to construct the component with, right away
+	 */
+	template <typename Component, typename... Args>
+	void add(target e, Args&&... args) {
+		record<Component>(command::add, e, std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @brief record overwriting an entity's component.
+	 * does nothing if the entity doesn't have one by then
+	 *
+	 * @param e the entity owning the component
+	 * @param args the arguments to construct the new value with, right away
+	 */
+	template <typename Component, typename... Args>
+	void replace(target e, Args&&... args) {
+		record<Component>(command::replace, e, std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @brief record removing a component from an entity.
+	 * does nothing if the entity doesn't have one by then
+	 */
+	template <typename Component>
+	void remove(target e) {
+		check(e);
+		m_commands.push_back(command{ command::remove, component_id<Component>(), e, nullptr, &apply<Component>, nullptr, nullptr });
+	}
+
+	/**
+	 * @brief play every recorded command back into the registry, then clear the buffer
+	 *
+	 * @return the entities created, in the order of their placeholders
+	 *
+	 * @remarks if a command throws, the commands not yet played back are dropped
+	 */
+	std::vector<entity_t> flush(registry& r);
+
+	/**
+	 * @brief drop every recorded command
+	 */
+	void clear();
+
+	/**
+	 * @return true if no command is recorded
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief play back the commands of several buffers in a single pass, pool by pool,
+	 * then clear them. see flush()
+	 */
+	static void flush(registry& r, const std::vector<command_buffer*>& buffers);
+
+private:
+	/// a recorded add, replace or remove of a component, or destruction of an entity
+	struct command {
+		enum kind_t { add,
+					  replace,
+					  remove,
+					  destroy } kind;
+		/// the component_id of the component, unused for destroy
+		size_t cid;
+		/// the entity to apply the command to
+		target e;
+		/// the component constructed for add and replace, or nullptr
+		void* payload;
+		/// applies the command to the entity with the given id
+		void (*apply)(registry&, entity_id, command&);
+		/// makes room in the pool for n more components, or nullptr
+		void (*reserve)(registry&, size_t);
+		/// destroys the payload, or nullptr
+		void (*dispose)(void*);
+	};
+
+	/// how many bytes of payloads each block of the arena holds, unless a payload is larger
+	static constexpr size_t BLOCK_SZ = 16 * 1024;
+	/// the alignment of each block of the arena
+	static constexpr size_t BLOCK_ALIGN = 64;
+
+	/// frees a block allocated with BLOCK_ALIGN
+	struct block_deleter {
+		void operator()(char* block) const;
+	};
+
+	/// the recorded commands, in order
+	std::vector<command> m_commands;
+	/// how many entities to create
+	size_t m_creates;
+	/// payloads are constructed back to back in these blocks
+	std::vector<std::unique_ptr<char[], block_deleter>> m_blocks;
+	/// how many bytes of the last block are used
+	size_t m_block_used;
+
+	/// record an add or replace, constructing the component right away
+	template <typename Component, typename... Args>
+	void record(command::kind_t kind, target e, Args&&... args) {
+		static_assert(alignof(Component) <= BLOCK_ALIGN, "component is too aligned to be recorded");
+		check(e);
+		void* mem = allocate(sizeof(Component), alignof(Component));
+		// pushed before the payload is constructed, so a throwing push_back leaves nothing to destroy
+		m_commands.push_back(command{ kind, component_id<Component>(), e, nullptr, &apply<Component>, &reserve<Component>, nullptr });
+		command& c = m_commands.back();
+		try {
+			c.payload = new (mem) Component{ std::forward<Args>(args)... };
+		} catch (...) {
+			m_commands.pop_back();
+			throw;
+		}
+		c.dispose = &dispose<Component>;
+	}
+
+	/**
+	 * @brief play back the commands of the buffers, then clear them
+	 *
+	 * @param created the ids of the entities created for each buffer's placeholders
+	 */
+	static void play(registry& r, const std::vector<command_buffer*>& buffers, const std::vector<std::vector<entity_id>>& created);
+
+	/// throws if the target is a placeholder of another buffer
+	void check(const target& e) const;
+
+	/// room for a payload in the arena
+	void* allocate(size_t size, size_t align);
+
+	/// applies a command on a component of the given type
+	template <typename Component>
+	static void apply(registry& r, entity_id id, command& c) {
+		if (!r.valid(id)) return;
+		entity_t e = r.at(id);
+		switch (c.kind) {
+		case command::add:
+			if (e.has<Component>()) {
+				e.get<Component>() = std::move(*static_cast<Component*>(c.payload));
+			} else {
+				e.add<Component>(std::move(*static_cast<Component*>(c.payload)));
+			}
+			break;
+		case command::replace:
+			if (e.has<Component>()) {
+				e.get<Component>() = std::move(*static_cast<Component*>(c.payload));
+			}
+			break;
+		case command::remove:
+			if (e.has<Component>()) {
+				e.remove<Component>();
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	/// makes room for n more components of the given type
+	template <typename Component>
+	static void reserve(registry& r, size_t n) {
+		const component_pool* p = r.find_pool<Component>();
+		r.reserve<Component>((p ? p->count() : 0) + n);
+	}
+
+	/// destroys a payload of the given type
+	template <typename Component>
+	static void dispose(void* payload) {
+		static_cast<Component*>(payload)->~Component();
+	}
+};
+
+/**
+ * @brief one command_buffer per thread, so threads record without contention,
+ * all played back together at a sync point
+ */
+class command_queue {
+public:
+	/**
+	 * @brief constructor
+	 *
+	 * @param r the registry to play the commands back into,
+	 * whose thread pool's workers each get a buffer
+	 *
+	 * @remarks the registry must not be given another thread pool with use_workers() while the queue exists
+	 */
+	command_queue(registry& r);
+
+	command_queue(const command_queue& other) = delete;
+	command_queue(command_queue&& other)	  = delete;
+	command_queue& operator=(const command_queue& other) = delete;
+	command_queue& operator=(command_queue&& other) = delete;
+
+	/**
+	 * @brief the buffer of the calling thread
+	 *
+	 * @remarks lock-free for the registry's worker threads. other threads look theirs up under a lock
+	 */
+	command_buffer& local();
+
+	/**
+	 * @brief play back the commands of every thread's buffer in a single pass, then clear them
+	 *
+	 * @remarks must not run while other threads are recording
+	 */
+	void flush();
+
+private:
+	/// the registry to play the commands back into
+	registry& m_reg;
+	/// the thread pool whose workers each get a buffer
+	thread_pool& m_workers;
+	/// the buffer of each worker, by index
+	std::vector<std::unique_ptr<command_buffer>> m_worker_buffers;
+	/// the buffers of threads outside the pool
+	std::unordered_map<std::thread::id, std::unique_ptr<command_buffer>> m_other_buffers;
+	/// guards m_other_buffers
+	std::mutex m_other_mtx;
+};
+
+}
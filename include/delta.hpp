@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <internal/entity_id.hpp>
+
+#include <registry.hpp>
+
+namespace ecs {
+
+/**
+ * @brief encodes the changes of a registry since the previous tick, to replicate it to a delta_decoder:
+ * the entities created and destroyed, and the components added, removed or changed since.
+ * changed components are sent XORed against their previous value and run-length encoded,
+ * so only the bytes that changed take room
+ *
+ * @remarks covers the plain-data component types registered for snapshots with register_component(),
+ * matched by name on the other end. each encoder keeps its own baseline, e.g. one per observer
+ */
+class delta_encoder {
+public:
+	/**
+	 * @brief constructor
+	 *
+	 * @param r the registry to encode the changes of. must outlive the encoder
+	 */
+	delta_encoder(const registry& r);
+
+	/**
+	 * @brief encode what changed since the previous call, or everything on the first call,
+	 * then make the current state the baseline of the next call
+	 *
+	 * @return the delta, to pass to delta_decoder::apply()
+	 */
+	std::vector<char> encode();
+
+	/**
+	 * @brief forget the baseline, so the next delta holds everything, e.g. for a new observer
+	 */
+	void reset();
+
+	/**
+	 * @return how many deltas were encoded since the baseline was last reset
+	 */
+	uint64_t tick() const;
+
+private:
+	/// ids as of the previous tick, looked up by entity index
+	struct id_table {
+		/// the ids, in the order of their components in the baseline
+		std::vector<entity_id> ids;
+		/// entity index -> position in ids, or npos
+		std::vector<size_t> slot;
+
+		/// replace the ids with the given ones
+		void assign(const std::pmr::vector<entity_id>& from);
+		/// the position of the id, or npos if absent or of another generation
+		size_t find(entity_id id) const;
+	};
+
+	/// the previous state of a pool
+	struct baseline_pool {
+		/// the component_id of the pool
+		size_t cid;
+		/// the entities owning the components
+		id_table ents;
+		/// the bytes of each component, parallel to ents.ids
+		std::vector<char> bytes;
+	};
+
+	/// the registry to encode
+	const registry& m_reg;
+	/// the entities as of the previous tick
+	id_table m_entities;
+	/// the pools as of the previous tick
+	std::vector<baseline_pool> m_pools;
+	/// how many deltas were encoded
+	uint64_t m_tick;
+	/// scratch space for one component
+	std::vector<char> m_scratch;
+
+	/**
+	 * @brief append the changes of one pool, and update its baseline
+	 *
+	 * @return false if nothing changed
+	 */
+	bool encode_pool(std::vector<char>& out, baseline_pool& base);
+
+	/// the bytes of the component at an index of a pool, possibly gathered into m_scratch
+	const char* component_bytes(const component_pool& pool, size_t idx);
+};
+
+/**
+ * @brief applies the deltas of a delta_encoder to a replica registry
+ *
+ * @remarks the replica must have the same component types registered for snapshots,
+ * and be changed by nothing else, so its entity ids stay those of the original
+ */
+class delta_decoder {
+public:
+	/**
+	 * @brief constructor
+	 *
+	 * @param r the replica registry. must outlive the decoder
+	 */
+	delta_decoder(registry& r);
+
+	/**
+	 * @brief apply a delta to the replica
+	 *
+	 * @remarks throws before changing the replica if the delta was not encoded
+	 * against the last one applied, names a type the replica doesn't know,
+	 * or doesn't fit what the replica holds: creating an entity whose index is in use,
+	 * adding a component an entity already has, or changing one it doesn't
+	 */
+	void apply(std::span<const char> delta);
+
+	/**
+	 * @return the tick of the last delta applied
+	 */
+	uint64_t tick() const;
+
+private:
+	/// the replica
+	registry& m_reg;
+	/// the tick of the last delta applied
+	uint64_t m_tick;
+};
+
+}
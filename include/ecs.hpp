@@ -1,5 +1,12 @@
 #pragma once
 
+#include <arena_resource.hpp>
+#include <command_buffer.hpp>
+#include <delta.hpp>
 #include <entity.hpp>
+#include <group.hpp>
+#include <observer.hpp>
+#include <query.hpp>
 #include <registry.hpp>
+#include <scheduler.hpp>
 #include <view.hpp>
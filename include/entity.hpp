@@ -5,37 +5,41 @@
 #include <stdexcept>
 #include <typeindex>
 #include <typeinfo>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include <internal/component_ref.hpp>
+#include <internal/entity_id.hpp>
+#include <internal/signature_set.hpp>
 #include <registry.hpp>
 
 namespace ecs {
 
 /**
- * @brief entity that stores references to all components it holds
- * provides apis to add and remove components at will
+ * @brief handle to an entity of a registry, made of the registry and the entity's id.
+ * cheap to copy, and provides apis to add and remove components at will
  */
 class entity {
 public:
-	~entity();
+	/**
+	 * @brief constructs a handle to no entity
+	 */
+	entity();
 
 	/**
 	 * @brief add a component to this entity
 	 *
 	 * @tparam Component the type of component to add
 	 * @param args the arguments to construct the component with
-	 * @returns Reference to the newly added component
+	 * @returns Reference to the newly added component, a soa_ref if stored as a structure of arrays
 	 */
 	template <typename Component, typename... Args>
-	Component& add(Args&&... args) {
+	component_ref_t<Component> add(Args&&... args) {
 		assert_alive();
-		std::type_index ti(typeid(Component));
-		if (m_lookup.contains(ti)) {
+		if (has<Component>()) {
 			throw std::runtime_error("Component already exists.");
 		}
-		size_t idx	 = m_reg.add<Component>(args...);
-		m_lookup[ti] = idx;
-		return m_reg.get<Component>(idx);
+		return m_reg->add<Component>(m_id, std::forward<Args>(args)...);
 	}
 
 	/**
@@ -46,12 +50,10 @@ public:
 	template <typename Component>
 	void remove() {
 		assert_alive();
-		std::type_index ti(typeid(Component));
-		if (!m_lookup.contains(ti)) {
+		if (!has<Component>()) {
 			throw std::runtime_error("Component type does not exist on entity");
 		}
-		m_reg.remove<Component>(m_lookup[ti]);
-		m_lookup.erase(ti);
+		m_reg->remove<Component>(m_id);
 	}
 
 	/**
@@ -62,7 +64,12 @@ public:
 	template <typename... Components>
 	bool has() const {
 		assert_alive();
-		return (true && ... && m_lookup.contains(std::type_index(typeid(Components))));
+		if constexpr (sizeof...(Components) == 1) {
+			return (m_reg->has<Components>(m_id) && ...);
+		} else {
+			// one test of the signature instead of a lookup per pool
+			return m_reg->signatures().matches(entity_index(m_id), component_mask::of<Components...>());
+		}
 	}
 
 	/**
@@ -83,36 +90,48 @@ public:
 	 * @brief retrieve the given component
 	 *
 	 * @tparam Component the component to retrieve
+	 * @return a reference to it, or a soa_ref if stored as a structure of arrays
 	 */
 	template <typename Component>
-	Component& get() {
+	component_ref_t<Component> get() {
 		assert_alive();
-		std::type_index ti(typeid(Component));
-		if (!m_lookup.contains(ti)) {
-			throw std::runtime_error("get() Component " + std::string(ti.name()) + " does not exist.");
-		}
-		return m_reg.get<Component>(m_lookup.at(ti));
+		return lookup<Component>(m_reg->find_pool<Component>());
 	}
 
 	/**
 	 * @brief retrieve the given component
 	 *
 	 * @tparam Component the component to retrieve
+	 * @return a reference to it, or a soa_ref if stored as a structure of arrays
 	 */
 	template <typename Component>
-	const Component& get() const {
+	component_ref_t<const Component> get() const {
 		assert_alive();
-		std::type_index ti(typeid(Component));
-		if (!m_lookup.contains(ti)) {
-			throw std::runtime_error("get() Component " + std::string(ti.name()) + " does not exist.");
-		}
-		return m_reg.get<Component>(m_lookup.at(ti));
+		return lookup<Component>(static_cast<const registry*>(m_reg)->find_pool<Component>());
 	}
 
 	/**
-	 * @brief clone this component
+	 * @brief modify a component in place, stamping it as changed if its type is tracked,
+	 * then signal registry::on_update()
 	 *
-	 * @return the new component
+	 * @tparam Component the component to modify
+	 * @param fn callable taking the component, by reference or as a soa_ref
+	 * @return the component
+	 */
+	template <typename Component, typename Fn>
+	component_ref_t<Component> patch(Fn&& fn) {
+		component_ref_t<Component> c = get<Component>();
+		fn(c);
+		m_reg->updated(component_id<Component>(), m_id);
+		return c;
+	}
+
+	/**
+	 * @brief clone this entity, copying each of its components
+	 *
+	 * @return the new entity
+	 *
+	 * @remarks throws before creating the entity if one of its components can't be copied
 	 */
 	entity_t clone() const;
 
@@ -120,37 +139,67 @@ public:
 	 * @brief lookup the id of the component
 	 *
 	 * @param ti the type index of the component
-	 * @return -1 if nonexistent, otherwise the index of that component for the respective pool
+	 * @return the index of that component in the packed array of the respective pool
+	 *
+	 * @remarks throws if nonexistent
 	 */
 	size_t lookup_id(std::type_index ti) const;
 
+	/**
+	 * @brief the id of this entity, used to key its components in the pools
+	 */
+	entity_id id() const;
+
 	/**
 	 * @brief true if the entity is still alive and usable
 	 */
 	bool alive() const;
 
+	/**
+	 * @brief allows handles to be used like pointers, e.g. e->get<T>()
+	 */
+	entity* operator->();
+
+	/**
+	 * @brief allows handles to be used like pointers, e.g. e->get<T>()
+	 */
+	const entity* operator->() const;
+
+	/// equality
+	friend bool operator==(const entity& a, const entity& b) {
+		return a.m_reg == b.m_reg && a.m_id == b.m_id;
+	}
+	friend bool operator!=(const entity& a, const entity& b) {
+		return !(a == b);
+	}
+
 private:
 	friend class registry;
-	entity(registry& r);
+	entity(registry& r, entity_id id);
 
 	/**
-	 * @brief frees all stored components, sets a flag that this entity is useless,
-	 * preventing method calls (called on destructor, and when removed by the registry)
+	 * @brief this entity's component in the pool, throwing if it has none
 	 */
-	void destroy();
-	bool m_destroyed;
+	template <typename Component, typename Pool>
+	component_ref_t<pool_component_t<Component, Pool>> lookup(Pool* pool) const {
+		size_t idx = pool ? pool->find(m_id) : sparse_set::npos;
+		if (idx == sparse_set::npos) {
+			throw std::runtime_error("get() Component " + std::string(typeid(Component).name()) + " does not exist.");
+		}
+		return component_ref<Component>(pool, idx);
+	}
 
 	/**
-	 * @brief check m_destroyed to make sure this entity is still active
+	 * @brief check that the entity is still in the registry, throwing if not
 	 */
 	void assert_alive() const;
 
 	/// registry this entity is assigned to
-	registry& m_reg;
+	registry* m_reg;
 
-	/// map of component types to their indices in the corresponding pool
-	std::unordered_map<std::type_index, size_t> m_lookup;
+	/// id of this entity in the registry
+	entity_id m_id;
 };
 
-typedef std::shared_ptr<entity> entity_t;
+typedef entity entity_t;
 }
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include <internal/component_pool.hpp>
+#include <internal/component_ref.hpp>
+#include <internal/group_storage.hpp>
+
+#include <entity.hpp>
+#include <registry.hpp>
+#include <view.hpp>
+
+namespace ecs {
+
+/**
+ * @brief an owning group, iterating the entities having all the components
+ * by walking the packed front of each pool in lockstep, with no lookups
+ *
+ * @remarks the registry keeps the group up to date as components are added and removed,
+ * but not during iteration: don't add or remove the group's components in a callback
+ */
+template <typename... Owned>
+class group {
+public:
+	/**
+	 * @brief runs a callback on each entity in the group
+	 *
+	 * @param callback any callable taking either (entity_t, Owned&...) or (Owned&...)
+	 */
+	template <typename Fn>
+	void each(Fn&& callback) {
+		static_assert(std::is_invocable_v<Fn&, entity_t, component_ref_t<Owned>...> || std::is_invocable_v<Fn&, component_ref_t<Owned>...>,
+					  "each() callback must take (entity_t, Owned&...) or (Owned&...)");
+		each_in(0, size(), callback);
+	}
+
+	/**
+	 * @brief runs a callback on each entity in the group,
+	 * split into chunks over the registry's thread pool
+	 *
+	 * @param callback same as each(), but called concurrently:
+	 * it must only modify the components of the entity it is given
+	 * @param options how to split the work
+	 */
+	template <typename Fn>
+	void par_each(Fn&& callback, par_options options = {}) {
+		static_assert(std::is_invocable_v<Fn&, entity_t, component_ref_t<Owned>...> || std::is_invocable_v<Fn&, component_ref_t<Owned>...>,
+					  "par_each() callback must take (entity_t, Owned&...) or (Owned&...)");
+		size_t n	  = size();
+		size_t grain  = std::max<size_t>(options.grain, 1);
+		size_t chunks = (n + grain - 1) / grain;
+		if (chunks <= 1) {
+			each_in(0, n, callback);
+			return;
+		}
+		m_reg->workers().run(chunks, [this, &callback, n, grain](size_t chunk) {
+			each_in(chunk * grain, std::min(n, (chunk + 1) * grain), callback);
+		});
+	}
+
+	/**
+	 * @brief runs a callback on the members of the group, one page of the pools at a time,
+	 * for loops the compiler can vectorize. each run starts on a component_pool::PAGE_ALIGN boundary
+	 *
+	 * @param callback any callable taking either (std::span<const entity_id>, std::span<Owned>...)
+	 * or (std::span<Owned>...), all of the same length
+	 */
+	template <typename Fn>
+	void each_chunk(Fn&& callback) {
+		static_assert(std::is_invocable_v<Fn&, std::span<const entity_id>, component_span_t<Owned>...> ||
+						  std::is_invocable_v<Fn&, component_span_t<Owned>...>,
+					  "each_chunk() callback must take (std::span<const entity_id>, std::span<Owned>...) or (std::span<Owned>...)");
+		const std::pmr::vector<entity_id>& ents = m_pools[0]->entities();
+		size_t n						   = size();
+		with_stamping([&](auto stamp) {
+			for (size_t begin = 0; begin < n; begin += component_pool::PAGE_SZ) {
+				size_t len = std::min(n - begin, component_pool::PAGE_SZ);
+				[&]<size_t... I>(std::index_sequence<I...>) {
+					if constexpr (std::is_invocable_v<Fn&, std::span<const entity_id>, component_span_t<Owned>...>) {
+						callback(std::span<const entity_id>(ents.data() + begin, len),
+								 component_span<Owned, decltype(stamp)::value>(m_pools[I], begin, len)...);
+					} else {
+						callback(component_span<Owned, decltype(stamp)::value>(m_pools[I], begin, len)...);
+					}
+				}
+				(std::index_sequence_for<Owned...>{});
+			}
+		});
+	}
+
+	/**
+	 * @return how many entities are in the group
+	 */
+	size_t size() const {
+		return m_storage->size();
+	}
+
+	/**
+	 * @return true if the entity is in the group
+	 */
+	bool contains(const entity_t& e) const {
+		return e == m_reg->handle(e.id()) && m_storage->contains(e.id());
+	}
+
+private:
+	friend class registry;
+
+	/**
+	 * @brief can only be instantiated by the registry api
+	 */
+	group(registry& r, group_storage& storage)
+		: m_reg(&r),
+		  m_storage(&storage),
+		  m_pools{ r.find_pool<Owned>()... } {
+	}
+
+	/**
+	 * @brief calls the callback on the members at the packed indices [begin, end)
+	 */
+	template <typename Fn>
+	void each_in(size_t begin, size_t end, Fn& callback) {
+		const std::pmr::vector<entity_id>& ents = m_pools[0]->entities();
+		with_stamping([&](auto stamp) {
+			for (size_t i = begin; i < end; ++i) {
+				[&]<size_t... I>(std::index_sequence<I...>) {
+					if constexpr (std::is_invocable_v<Fn&, entity_t, component_ref_t<Owned>...>) {
+						callback(m_reg->handle(ents[i]), component_ref<Owned, decltype(stamp)::value>(m_pools[I], i)...);
+					} else {
+						callback(component_ref<Owned, decltype(stamp)::value>(m_pools[I], i)...);
+					}
+				}
+				(std::index_sequence_for<Owned...>{});
+			}
+		});
+	}
+
+	/**
+	 * @brief calls body with std::true_type if handing out the components must stamp them as changed,
+	 * or std::false_type if none of the pools is tracked, keeping the per-component check out of the loop
+	 */
+	template <typename Body>
+	void with_stamping(Body&& body) {
+		if (std::any_of(m_pools.begin(), m_pools.end(), [](const component_pool* p) { return p->tracked(); })) {
+			body(std::true_type{});
+		} else {
+			body(std::false_type{});
+		}
+	}
+
+	/// the registry this group originates from
+	registry* m_reg;
+	/// which entities are in the group
+	group_storage* m_storage;
+	/// the pool of each component, in the order of Owned
+	std::array<component_pool*, sizeof...(Owned)> m_pools;
+};
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief reads values back from bytes in memory, e.g. a snapshot or a delta
+ *
+ * @remarks throws if reading past the end
+ */
+class byte_reader {
+public:
+	byte_reader(const char* data, size_t size)
+		: m_data(data),
+		  m_size(size),
+		  m_pos(0) {
+	}
+
+	/**
+	 * @brief read a value stored as its raw bytes
+	 */
+	template <typename T>
+	T read() {
+		T value;
+		std::memcpy(&value, bytes(sizeof(T)), sizeof(T));
+		return value;
+	}
+
+	/**
+	 * @brief read an unsigned integer written by write_varint()
+	 */
+	uint64_t read_varint() {
+		uint64_t value = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			uint8_t byte = read<uint8_t>();
+			value |= uint64_t(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) return value;
+		}
+		throw std::runtime_error("Malformed varint.");
+	}
+
+	/**
+	 * @return the next n bytes
+	 */
+	const char* bytes(size_t n) {
+		if (n > m_size - m_pos) {
+			throw std::runtime_error("Data is truncated.");
+		}
+		const char* p = m_data + m_pos;
+		m_pos += n;
+		return p;
+	}
+
+	/**
+	 * @return the next count items of size bytes each
+	 *
+	 * @remarks checks the count against what is left before multiplying, so a huge count can't wrap around
+	 */
+	const char* bytes(size_t count, size_t size) {
+		if (size != 0 && count > remaining() / size) {
+			throw std::runtime_error("Data is truncated.");
+		}
+		return bytes(count * size);
+	}
+
+	/**
+	 * @brief skip to the next multiple of align
+	 */
+	void align(size_t align) {
+		bytes((align - m_pos % align) % align);
+	}
+
+	/**
+	 * @return how many bytes are left to read
+	 */
+	size_t remaining() const {
+		return m_size - m_pos;
+	}
+
+	/**
+	 * @return true if every byte was read
+	 */
+	bool done() const {
+		return m_pos == m_size;
+	}
+
+private:
+	/// the bytes to read
+	const char* m_data;
+	/// how many bytes there are
+	size_t m_size;
+	/// how many bytes were read
+	size_t m_pos;
+};
+
+/**
+ * @brief append a value as its raw bytes
+ */
+template <typename T>
+void write_bytes(std::vector<char>& out, const T& value) {
+	size_t at = out.size();
+	out.resize(at + sizeof(T));
+	std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+/**
+ * @brief append an unsigned integer in as few bytes as it needs, 7 bits at a time
+ */
+inline void write_varint(std::vector<char>& out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+}
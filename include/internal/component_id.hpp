@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ecs {
+
+/**
+ * @brief hands out the next unused component id
+ */
+size_t next_component_id();
+
+/**
+ * @brief dense, sequential id of a component type, assigned on first use.
+ * used to index the registry's pools without hashing a std::type_index
+ *
+ * @tparam Component the component type
+ */
+template <typename Component>
+size_t component_id() {
+	static const size_t id = next_component_id();
+	return id;
+}
+
+}
@@ -1,85 +1,405 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <internal/lifecycle.hpp>
+#include <internal/soa.hpp>
+#include <internal/sparse_set.hpp>
 
 namespace ecs {
 
 /**
- * @brief stores a specific type of entity
+ * @brief stores a specific type of component as a sparse set:
+ * the components are packed in a dense array, parallel to a dense array
+ * of the entities owning them
+ *
+ * @remarks the dense array is split into fixed-size pages allocated on demand,
+ * so components never move when the pool grows.
+ * components are stored whole, unless the pool is given the fields to split them into:
+ * each page then holds one array per field (a structure of arrays).
+ * components are copied, moved and destroyed through the lifecycle the pool is given,
+ * falling back to copying bytes for types where that is equivalent.
+ * once tracked, the pool stamps each component with the tick it was added and last changed in,
+ * and each page with the latest of those, so unchanged pages can be skipped
  */
 class component_pool {
 public:
-	component_pool(size_t max_sz, size_t comp_sz);
+	/// max_sz of a pool without a hard cap on its size
+	static constexpr size_t unlimited = static_cast<size_t>(-1);
+	/// how many components are stored in each page
+	static constexpr size_t PAGE_SZ = 1024;
+	/// the minimum alignment (in bytes) of each page, enough for aligned simd loads of packed components
+	static constexpr size_t PAGE_ALIGN = 64;
+
+	/**
+	 * @brief constructor
+	 *
+	 * @param max_sz the maximum amount of components
+	 * @param comp_sz the size (in bytes) of each component
+	 * @param fields the fields to store in separate arrays, or none to store components whole
+	 * @param ops how to copy, move and destroy the components, which must be trivial for a structure of arrays
+	 * @param resource where to allocate the pages and the entity arrays from. must outlive the pool
+	 * @param comp_align the alignment (in bytes) of each component, pages are aligned to at least PAGE_ALIGN
+	 */
+	component_pool(size_t max_sz, size_t comp_sz, std::vector<soa_field> fields = {}, lifecycle ops = lifecycle::trivial(),
+				   std::pmr::memory_resource* resource = std::pmr::get_default_resource(), size_t comp_align = PAGE_ALIGN);
 	~component_pool();
 
+	/**
+	 * @brief the layout of the pages of a pool of the given components, without constructing one
+	 *
+	 * @return the page_bytes() and page_align() such a pool would have
+	 */
+	static std::pair<size_t, size_t> page_layout(size_t comp_sz, const std::vector<soa_field>& fields = {}, size_t comp_align = PAGE_ALIGN);
+
 	component_pool(const component_pool& other) = delete;
 	component_pool(component_pool&& other)		= delete;
 
 	/**
 	 * @brief add a component to the pool
 	 *
-	 * @param t the component data
-	 * @return the index of that component
+	 * @param entity the id of the entity owning the component
+	 * @param args the arguments to construct the component with
+	 * @return the newly added component, or nullptr if the pool is a structure of arrays
 	 *
-	 * @remarks throws if the pool is full
+	 * @remarks throws if the pool is full, or the entity already has a component in this pool
 	 */
 	template <typename Component, typename... Args>
-	size_t add(Args&&... args) {
+	Component* add(entity_id entity, Args&&... args) {
 		if (sizeof(Component) != COMP_SZ) {
 			throw std::runtime_error("Attempt to add a component of incompatible size.");
 		}
-		if (m_next_slot >= MAX_SZ) {
-			throw std::out_of_range(
-				"Not enough room in the component pool! \
-				(make the max size larger)");
+		if (m_set.contains(entity)) {
+			throw std::runtime_error("Component already exists.");
+		}
+		grow(m_set.size() + 1);
+		if (soa()) {
+			Component c{ std::forward<Args>(args)... };
+			store(m_set.insert(entity), &c);
+			stamp_new(m_set.size() - 1);
+			return nullptr;
+		}
+		// the entity is inserted first, so a component constructed is always one the pool destroys
+		size_t idx		= m_set.insert(entity);
+		Component* data = at<Component>(idx);
+		try {
+			new (data)(Component){ std::forward<Args>(args)... };
+		} catch (...) {
+			m_set.remove(entity);
+			throw;
 		}
-		size_t slot		= m_next_slot;
-		Component* data = reinterpret_cast<Component*>(m_data);
-		new (data + slot)(Component){ args... };
-
-		set_bit(slot);
-		find_free_slot();
-		m_count++;
-		return slot;
+		stamp_new(idx);
+		return data;
 	}
 
 	/**
-	 * @brief clone an index into the next available slot
+	 * @brief clone an entity's component into a new entity
 	 *
-	 * @param idx the index of the component to clone
-	 * @return the index of the cloned component
+	 * @param from the id of the entity to clone the component of
+	 * @param to the id of the entity to give the cloned component
 	 *
-	 * @remarks This is a shallow clone!
+	 * @remarks throws if the component can't be copied
 	 */
-	size_t clone(size_t idx);
+	void clone(entity_id from, entity_id to);
 
 	/**
-	 * @brief retrieve a component given the index
+	 * @brief retrieve the component owned by an entity
 	 *
-	 * @param idx the index of the component
-	 * @return the component at that index
+	 * @param entity the id of the entity
+	 * @return the component of that entity
 	 *
-	 * @remarks throws if that component index does not exist
+	 * @remarks throws if that entity has no component in this pool
 	 */
 	template <typename T>
-	T* get(size_t idx) {
-		if (idx >= MAX_SZ) {
-			throw std::out_of_range("Attempt to get a component out of bounds.");
-		}
-		if (!is_set(idx)) {
-			throw std::out_of_range("Component at index does not exist.");
-		}
-		return reinterpret_cast<T*>(m_data) + idx;
+	T* get(entity_id entity) {
+		return at<T>(m_set.index(entity));
 	}
 
 	/**
-	 * @brief remove a component from the pool
+	 * @brief retrieve the component owned by an entity
+	 *
+	 * @param entity the id of the entity
+	 * @return the component of that entity
 	 *
-	 * @param idx the element index to remove
+	 * @remarks throws if that entity has no component in this pool
+	 */
+	template <typename T>
+	const T* get(entity_id entity) const {
+		return at<T>(m_set.index(entity));
+	}
+
+	/**
+	 * @brief retrieve the component owned by an entity
+	 *
+	 * @param entity the id of the entity
+	 * @return the component of that entity, or nullptr if it has none in this pool
+	 */
+	template <typename T>
+	T* try_get(entity_id entity) {
+		size_t idx = m_set.find(entity);
+		return idx == sparse_set::npos ? nullptr : at<T>(idx);
+	}
+
+	/**
+	 * @brief retrieve the component owned by an entity
+	 *
+	 * @param entity the id of the entity
+	 * @return the component of that entity, or nullptr if it has none in this pool
+	 */
+	template <typename T>
+	const T* try_get(entity_id entity) const {
+		size_t idx = m_set.find(entity);
+		return idx == sparse_set::npos ? nullptr : at<T>(idx);
+	}
+
+	/**
+	 * @brief retrieve a component by its index in the packed array, parallel to entities()
+	 *
+	 * @remarks does not check bounds
+	 */
+	template <typename T>
+	T* at(size_t idx) {
+		return reinterpret_cast<T*>(m_pages[idx / PAGE_SZ].get()) + (idx % PAGE_SZ);
+	}
+
+	/**
+	 * @brief retrieve a component by its index in the packed array, parallel to entities()
+	 *
+	 * @remarks does not check bounds
+	 */
+	template <typename T>
+	const T* at(size_t idx) const {
+		return reinterpret_cast<const T*>(m_pages[idx / PAGE_SZ].get()) + (idx % PAGE_SZ);
+	}
+
+	/**
+	 * @return true if the components are split into one array per field
 	 */
-	void remove(size_t idx);
+	bool soa() const;
+
+	/**
+	 * @brief the address of one field of a component. fields of consecutive components
+	 * on the same page are contiguous
+	 *
+	 * @param field the index of the field, always 0 if the pool stores components whole
+	 * @param idx the index of the component in the packed array
+	 *
+	 * @remarks does not check bounds
+	 */
+	char* field(size_t field, size_t idx) {
+		const slice& f = m_fields[field];
+		return m_pages[idx / PAGE_SZ].get() + f.page_offset + (idx % PAGE_SZ) * f.size;
+	}
+
+	/**
+	 * @brief the address of one field of a component. fields of consecutive components
+	 * on the same page are contiguous
+	 *
+	 * @param field the index of the field, always 0 if the pool stores components whole
+	 * @param idx the index of the component in the packed array
+	 *
+	 * @remarks does not check bounds
+	 */
+	const char* field(size_t field, size_t idx) const {
+		const slice& f = m_fields[field];
+		return m_pages[idx / PAGE_SZ].get() + f.page_offset + (idx % PAGE_SZ) * f.size;
+	}
+
+	/**
+	 * @brief copy a whole component into the pool, splitting it into its fields
+	 *
+	 * @param idx the index of the component in the packed array
+	 * @param component the component to copy, COMP_SZ bytes
+	 */
+	void store(size_t idx, const void* component);
+
+	/**
+	 * @brief copy a component out of the pool, gathering its fields
+	 *
+	 * @param idx the index of the component in the packed array
+	 * @param out where to copy the component to, COMP_SZ bytes
+	 */
+	void load(size_t idx, void* out) const;
+
+	/**
+	 * @return true if the components can be copied, e.g. to clone them
+	 */
+	bool copyable() const;
+
+	/**
+	 * @brief remove an entity's component from the pool,
+	 * moving the last component into its place
+	 *
+	 * @param entity the id of the entity
+	 */
+	void remove(entity_id entity);
+
+	/**
+	 * @brief swap the components (and their entities) at two indices of the packed array
+	 *
+	 * @remarks does not check bounds
+	 */
+	void swap(size_t a, size_t b);
+
+	/**
+	 * @brief allocate enough pages to store n components
+	 *
+	 * @remarks throws if n exceeds the maximum size of the pool
+	 */
+	void reserve(size_t n);
+
+	/**
+	 * @brief release the pages no component is stored in,
+	 * and the memory the sparse set holds on to for removed entities
+	 *
+	 * @return how many bytes were released
+	 */
+	size_t shrink_to_fit();
+
+	/**
+	 * @brief reorder the packed arrays to follow the given order, a few positions at a time
+	 *
+	 * @param order the entities of the pool in the order to arrange them in
+	 * @param pos the position of the packed arrays to resume from, advanced past each position arranged
+	 * @param budget how many positions to arrange at most, each costing at most one swap
+	 * @return false if order no longer lists the entities of the pool, in which case it stops there
+	 */
+	bool arrange(const std::vector<entity_id>& order, size_t& pos, size_t budget);
+
+	/**
+	 * @brief take over pages of components laid out like this pool's, e.g. mapped from a snapshot,
+	 * instead of allocating and filling them
+	 *
+	 * @param ents the entities owning the components, in order
+	 * @param n how many components there are
+	 * @param pages the (n + PAGE_SZ - 1) / PAGE_SZ pages holding them, each page_bytes() long
+	 * and aligned to page_align(). the pool doesn't free them, so they must outlive it
+	 *
+	 * @remarks throws if the pool isn't empty, its components aren't trivial, or there are too many
+	 */
+	void adopt(const entity_id* ents, size_t n, const std::vector<char*>& pages);
+
+	/**
+	 * @return the start of the i-th page, PAGE_SZ components laid out as field() describes
+	 *
+	 * @remarks does not check bounds
+	 */
+	const char* page(size_t i) const;
+
+	/**
+	 * @return the size (in bytes) of each page
+	 */
+	size_t page_bytes() const;
+
+	/**
+	 * @return the alignment (in bytes) of each page
+	 */
+	size_t page_align() const;
+
+	/**
+	 * @return the size (in bytes) of each component
+	 */
+	size_t component_size() const;
+
+	/**
+	 * @return true if components are copied, moved and destroyed as plain bytes
+	 */
+	bool trivial() const;
+
+	/**
+	 * @brief start stamping components with the tick they are added and changed in
+	 *
+	 * @param clock the current tick, read on every stamp. must outlive the pool
+	 *
+	 * @remarks the components already stored are stamped with tick 0
+	 */
+	void track(const uint64_t* clock);
+
+	/**
+	 * @return true if the pool stamps its components with ticks
+	 */
+	bool tracked() const;
+
+	/**
+	 * @brief stamp the component at an index as changed in the current tick, if the pool is tracked
+	 *
+	 * @remarks safe to call concurrently for different indices
+	 */
+	void touch(size_t idx) {
+		if (!m_clock) return;
+		m_changed[idx] = *m_clock;
+		raise(m_page_changed[idx / PAGE_SZ], *m_clock);
+	}
+
+	/**
+	 * @brief stamp len consecutive components on the same page as changed in the current tick, if the pool is tracked
+	 */
+	void touch(size_t idx, size_t len) {
+		if (!m_clock || len == 0) return;
+		std::fill_n(m_changed.begin() + idx, len, *m_clock);
+		raise(m_page_changed[idx / PAGE_SZ], *m_clock);
+	}
+
+	/**
+	 * @return the tick the component at an index was added in
+	 *
+	 * @remarks the pool must be tracked. does not check bounds
+	 */
+	uint64_t added_at(size_t idx) const;
+
+	/**
+	 * @return the tick the component at an index was last changed (or added) in
+	 *
+	 * @remarks the pool must be tracked. does not check bounds
+	 */
+	uint64_t changed_at(size_t idx) const;
+
+	/**
+	 * @return a tick no component of the i-th page was added after
+	 *
+	 * @remarks the pool must be tracked. does not check bounds
+	 */
+	uint64_t page_added_at(size_t i) const;
+
+	/**
+	 * @return a tick no component of the i-th page was changed after
+	 *
+	 * @remarks the pool must be tracked. does not check bounds
+	 */
+	uint64_t page_changed_at(size_t i) const;
+
+	/**
+	 * @return how many components can be stored without allocating
+	 */
+	size_t capacity() const;
+
+	/**
+	 * @return true if the entity has a component in this pool
+	 */
+	bool contains(entity_id entity) const;
+
+	/**
+	 * @return the index of the entity's component in the packed array
+	 */
+	size_t index(entity_id entity) const;
+
+	/**
+	 * @return the index of the entity's component in the packed array, or sparse_set::npos if it has none
+	 */
+	size_t find(entity_id entity) const;
+
+	/**
+	 * @brief the packed array of entities owning the components, parallel to at()
+	 */
+	const std::pmr::vector<entity_id>& entities() const;
 
 	/**
 	 * @return how many components are currently stored
@@ -92,24 +412,81 @@ private:
 	/// the size (in bytes) of each component
 	const size_t COMP_SZ;
 
-	/// the stored components
-	char* m_data;
-	/// the next open slot in the component
-	size_t m_next_slot;
-	/// a collection of bits, each set to 1 if the corresponding data block is used
-	char* m_storage_bitmask;
-	/// how many components are currently stored
-	size_t m_count;
-
-	/// finds the next free slot >m_next_slot
-	void find_free_slot();
-
-	/// sets the bit in the storage bitmask
-	void set_bit(size_t idx);
-	/// unsets the bit in the storage bitmask
-	void unset_bit(size_t idx);
-	/// check if bit is set
-	bool is_set(size_t idx) const;
+	/// returns a page to the resource it came from, or does nothing for adopted pages
+	struct page_deleter {
+		std::pmr::memory_resource* resource;
+		size_t bytes;
+		size_t align;
+		void operator()(char* page) const;
+	};
+
+	/// where a field sits, in the component and in each page
+	struct slice {
+		/// the offset (in bytes) of the field in the component
+		size_t offset;
+		/// the size (in bytes) of the field
+		size_t size;
+		/// the offset (in bytes) of the field's array in each page
+		size_t page_offset;
+	};
+
+	/// how to copy, move and destroy the components
+	lifecycle m_ops;
+	/// the fields stored in separate arrays, or a single field spanning the component if stored whole
+	std::vector<slice> m_fields;
+	/// the resource pages are allocated from
+	std::pmr::memory_resource* m_resource;
+	/// the alignment (in bytes) of each page, and of each field's array in it
+	size_t m_page_align;
+	/// the size (in bytes) of each page
+	size_t m_page_bytes;
+
+	/// the stored components, packed, in the same order as the entities of m_set.
+	/// each page holds PAGE_SZ components, and starts on a m_page_align boundary
+	std::pmr::vector<std::unique_ptr<char[], page_deleter>> m_pages;
+	/// the entities owning the stored components
+	sparse_set m_set;
+
+	/// the current tick, or nullptr if the pool is not tracked
+	const uint64_t* m_clock;
+	/// the tick each component was added in, parallel to the packed array and as long as the pages
+	std::pmr::vector<uint64_t> m_added;
+	/// the tick each component was last changed in, parallel to the packed array and as long as the pages
+	std::pmr::vector<uint64_t> m_changed;
+	/// for each page, at least the latest tick of m_added on it.
+	/// raised when a component moves in, never lowered, so it may be later than any component left
+	std::pmr::vector<uint64_t> m_page_added;
+	/// for each page, at least the latest tick of m_changed on it, like m_page_added
+	std::pmr::vector<uint64_t> m_page_changed;
+
+	/// allocate pages until n components fit, throwing if n exceeds MAX_SZ
+	void grow(size_t n);
+
+	/// copy-construct a component in the empty slot dst from the one at src
+	void copy(size_t dst, size_t src);
+
+	/// move the component at src into the empty slot dst, leaving src empty
+	void relocate(size_t dst, size_t src);
+
+	/// destroy the component at idx, leaving its slot empty
+	void destroy(size_t idx);
+
+	/// size the ticks to the pages, if tracked
+	void fit_ticks();
+
+	/// stamp the component at idx as added and changed in the current tick, if tracked
+	void stamp_new(size_t idx);
+
+	/// move the ticks of the component at src to dst, if tracked
+	void move_ticks(size_t dst, size_t src);
+
+	/// raise the tick of a page to at least the given one, from any thread
+	static void raise(uint64_t& page_tick, uint64_t tick) {
+		std::atomic_ref<uint64_t> ref(page_tick);
+		if (ref.load(std::memory_order_relaxed) < tick) {
+			ref.store(tick, std::memory_order_relaxed);
+		}
+	}
 };
 
 }
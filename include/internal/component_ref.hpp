@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#include <internal/component_pool.hpp>
+#include <internal/soa.hpp>
+
+namespace ecs {
+
+/**
+ * @brief reference to a component stored as a structure of arrays,
+ * handed out in place of Component& as its fields are not next to each other
+ *
+ * @tparam Component the component, const for read-only access
+ */
+template <typename Component>
+class soa_ref {
+public:
+	/// the component, without const
+	using value_type = std::remove_const_t<Component>;
+	/// the pool, const if the component is
+	using pool_type = std::conditional_t<std::is_const_v<Component>, const component_pool, component_pool>;
+
+	soa_ref(pool_type* pool, size_t idx)
+		: m_pool(pool),
+		  m_idx(idx) {
+	}
+
+	/**
+	 * @brief retrieve one field of the component, e.g. get<&position::x>()
+	 */
+	template <auto Field>
+	auto& get() const {
+		constexpr size_t f = soa_layout<value_type>::template index_of<Field>();
+		static_assert(f < soa_layout<value_type>::count, "not a field of the component");
+		using field_t = typename member_traits<decltype(Field)>::field_type;
+		using ref_t	  = std::conditional_t<std::is_const_v<Component>, const field_t, field_t>;
+		return *reinterpret_cast<ref_t*>(m_pool->field(f, m_idx));
+	}
+
+	/**
+	 * @brief copy the whole component out of the pool
+	 */
+	value_type load() const {
+		value_type c{};
+		m_pool->load(m_idx, &c);
+		return c;
+	}
+
+	/// copy the whole component out of the pool
+	operator value_type() const {
+		return load();
+	}
+
+	/**
+	 * @brief overwrite the whole component
+	 */
+	const soa_ref& operator=(const value_type& c) const requires(!std::is_const_v<Component>) {
+		m_pool->store(m_idx, &c);
+		return *this;
+	}
+
+	/// read-only access to the same component
+	operator soa_ref<const Component>() const {
+		return soa_ref<const Component>(m_pool, m_idx);
+	}
+
+private:
+	/// the pool storing the component
+	pool_type* m_pool;
+	/// the index of the component in the packed array
+	size_t m_idx;
+};
+
+/**
+ * @brief a run of consecutive components stored as a structure of arrays, on a single page,
+ * handed out in place of std::span<Component> to reach each field's array
+ *
+ * @tparam Component the component, const for read-only access
+ */
+template <typename Component>
+class soa_span {
+public:
+	/// the component, without const
+	using value_type = std::remove_const_t<Component>;
+	/// the pool, const if the component is
+	using pool_type = std::conditional_t<std::is_const_v<Component>, const component_pool, component_pool>;
+
+	soa_span(pool_type* pool, size_t begin, size_t len)
+		: m_pool(pool),
+		  m_begin(begin),
+		  m_len(len) {
+	}
+
+	/**
+	 * @brief the contiguous array of one field of the components, e.g. get<&position::x>()
+	 */
+	template <auto Field>
+	auto get() const {
+		constexpr size_t f = soa_layout<value_type>::template index_of<Field>();
+		static_assert(f < soa_layout<value_type>::count, "not a field of the component");
+		using field_t = typename member_traits<decltype(Field)>::field_type;
+		using elem_t  = std::conditional_t<std::is_const_v<Component>, const field_t, field_t>;
+		return std::span<elem_t>(reinterpret_cast<elem_t*>(m_pool->field(f, m_begin)), m_len);
+	}
+
+	/**
+	 * @return a reference to the i-th component of the run
+	 */
+	soa_ref<Component> operator[](size_t i) const {
+		return soa_ref<Component>(m_pool, m_begin + i);
+	}
+
+	/**
+	 * @return how many components are in the run
+	 */
+	size_t size() const {
+		return m_len;
+	}
+
+private:
+	/// the pool storing the components
+	pool_type* m_pool;
+	/// the index of the first component in the packed array
+	size_t m_begin;
+	/// how many components there are
+	size_t m_len;
+};
+
+/**
+ * @brief what views and entities hand out to access a component:
+ * Component& if it is stored whole, or a soa_ref if stored as a structure of arrays
+ *
+ * @tparam Component the component, const for read-only access
+ */
+template <typename Component>
+using component_ref_t = std::conditional_t<is_soa_v<Component>, soa_ref<Component>, Component&>;
+
+/**
+ * @brief what chunked iteration hands out to access a run of components:
+ * std::span<Component> if they are stored whole, or a soa_span if stored as a structure of arrays
+ *
+ * @tparam Component the component, const for read-only access
+ */
+template <typename Component>
+using component_span_t = std::conditional_t<is_soa_v<Component>, soa_span<Component>, std::span<Component>>;
+
+/**
+ * @brief Component, const if the pool is
+ */
+template <typename Component, typename Pool>
+using pool_component_t = std::conditional_t<std::is_const_v<Pool>, const Component, Component>;
+
+/**
+ * @brief access the component at an index of a pool's packed array.
+ * handing out a mutable reference stamps the component as changed, if its pool is tracked
+ *
+ * @tparam Stamp false to skip stamping, for loops that already know the pool is not tracked
+ * @remarks does not check bounds
+ */
+template <typename Component, bool Stamp = true, typename Pool>
+component_ref_t<pool_component_t<Component, Pool>> component_ref(Pool* pool, size_t idx) {
+	if constexpr (Stamp && !std::is_const_v<Pool>) {
+		pool->touch(idx);
+	}
+	if constexpr (is_soa_v<Component>) {
+		return soa_ref<pool_component_t<Component, Pool>>(pool, idx);
+	} else {
+		return *pool->template at<Component>(idx);
+	}
+}
+
+/**
+ * @brief access the component an entity has in a pool, stamping it as changed like component_ref()
+ *
+ * @param pool the pool, or nullptr if there is none
+ * @return the component, or nullptr if the entity has none
+ */
+template <typename Component, typename Pool>
+pool_component_t<Component, Pool>* component_ptr(Pool* pool, entity_id id) {
+	static_assert(!is_soa_v<Component>, "components stored as a structure of arrays have no address");
+	size_t idx = pool ? pool->find(id) : sparse_set::npos;
+	return idx == sparse_set::npos ? nullptr : &component_ref<Component>(pool, idx);
+}
+
+/**
+ * @brief access len consecutive components from an index of a pool's packed array, all on the same page.
+ * handing out mutable components stamps them as changed, if their pool is tracked
+ *
+ * @tparam Stamp false to skip stamping, like component_ref()
+ * @remarks does not check bounds
+ */
+template <typename Component, bool Stamp = true, typename Pool>
+component_span_t<pool_component_t<Component, Pool>> component_span(Pool* pool, size_t idx, size_t len) {
+	if constexpr (Stamp && !std::is_const_v<Pool>) {
+		pool->touch(idx, len);
+	}
+	if constexpr (is_soa_v<Component>) {
+		return soa_span<pool_component_t<Component, Pool>>(pool, idx, len);
+	} else {
+		return std::span(pool->template at<Component>(idx), len);
+	}
+}
+
+}
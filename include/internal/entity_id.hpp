@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecs {
+
+/**
+ * @brief an entity as a plain integer.
+ * the low ENTITY_INDEX_BITS bits index the registry's entity table,
+ * the remaining high bits count how many times that index was recycled
+ */
+typedef std::uint32_t entity_id;
+
+/// how many low bits of an entity_id store its index
+constexpr size_t ENTITY_INDEX_BITS = 22;
+/// mask of the index bits of an entity_id
+constexpr entity_id ENTITY_INDEX_MASK = (entity_id(1) << ENTITY_INDEX_BITS) - 1;
+/// the id of no entity
+constexpr entity_id null_entity = ~entity_id(0);
+
+/**
+ * @return the index part of an entity id
+ */
+constexpr size_t entity_index(entity_id id) {
+	return id & ENTITY_INDEX_MASK;
+}
+
+/**
+ * @return the generation part of an entity id
+ */
+constexpr entity_id entity_generation(entity_id id) {
+	return id >> ENTITY_INDEX_BITS;
+}
+
+/**
+ * @brief combine an index and a generation into an entity id
+ */
+constexpr entity_id make_entity_id(size_t index, entity_id generation) {
+	return (generation << ENTITY_INDEX_BITS) | (entity_id(index) & ENTITY_INDEX_MASK);
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <internal/component_pool.hpp>
+#include <internal/entity_id.hpp>
+
+namespace ecs {
+
+/**
+ * @brief the state of an owning group: the entities having every owned component
+ * are kept packed at the front of each owned pool, in the same order,
+ * so the group's components sit at the same index of every pool
+ */
+class group_storage {
+public:
+	/**
+	 * @brief take ownership of the pools, packing the entities already having every component
+	 *
+	 * @param owned the component_id of each owned pool
+	 * @param pools the owned pools, parallel to owned
+	 */
+	group_storage(std::vector<size_t> owned, std::vector<component_pool*> pools);
+
+	group_storage(const group_storage& other) = delete;
+	group_storage(group_storage&& other)	  = delete;
+
+	/**
+	 * @return true if this group owns the pool of the component with the given component_id
+	 */
+	bool owns(size_t cid) const;
+
+	/**
+	 * @brief the component_id of each owned pool
+	 */
+	const std::vector<size_t>& owned() const;
+
+	/**
+	 * @return how many entities are in the group, i.e. the length of the packed prefix of each pool
+	 */
+	size_t size() const;
+
+	/**
+	 * @return true if the entity is in the group
+	 */
+	bool contains(entity_id id) const;
+
+	/**
+	 * @brief call after adding an owned component to an entity,
+	 * packs the entity into the group if it now has every owned component
+	 */
+	void added(entity_id id);
+
+	/**
+	 * @brief call before removing an owned component from an entity,
+	 * moves the entity out of the group if it was in it
+	 */
+	void removing(entity_id id);
+
+private:
+	/// the component_id of each owned pool
+	std::vector<size_t> m_owned;
+	/// the owned pools
+	std::vector<component_pool*> m_pools;
+	/// how many entities are packed at the front of the pools
+	size_t m_size;
+
+	/// move the entity to the given index of every owned pool
+	void move_to(entity_id id, size_t idx);
+};
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ecs {
+
+/**
+ * @brief true if moving a component to another address and forgetting the original
+ * is the same as copying its bytes, e.g. specialize it for a type that holds no pointer into itself.
+ * defaults to trivially copyable types
+ */
+template <typename T>
+struct trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool trivially_relocatable_v = trivially_relocatable<T>::value;
+
+/**
+ * @brief how to copy, move and destroy a component, captured when its pool is created
+ * so the pool can manage components whose type it doesn't know.
+ * each operation is nullptr when copying the bytes (or doing nothing, to destroy) is enough
+ */
+struct lifecycle {
+	/// copy-constructs the component at dst from the one at src
+	void (*copy)(void* dst, const void* src);
+	/// move-constructs the component at dst from the one at src, then destroys the one at src
+	void (*relocate)(void* dst, void* src);
+	/// exchanges two components
+	void (*swap)(void* a, void* b);
+	/// destroys the component
+	void (*destroy)(void* p);
+	/// false if the component can't be copied at all
+	bool copyable;
+
+	/**
+	 * @brief the operations of a plain-data component, all done by copying bytes
+	 */
+	static constexpr lifecycle trivial() {
+		return lifecycle{ nullptr, nullptr, nullptr, nullptr, true };
+	}
+
+	/**
+	 * @brief the operations of the given component, using its constructors and destructor
+	 * unless copying its bytes is equivalent
+	 */
+	template <typename T>
+	static constexpr lifecycle of() {
+		lifecycle ops = trivial();
+		if constexpr (!std::is_trivially_copyable_v<T>) {
+			if constexpr (std::is_copy_constructible_v<T>) {
+				ops.copy = [](void* dst, const void* src) {
+					new (dst) T(*static_cast<const T*>(src));
+				};
+			} else {
+				ops.copyable = false;
+			}
+		}
+		if constexpr (!trivially_relocatable_v<T>) {
+			static_assert(std::is_move_constructible_v<T>, "a component must be movable or copyable");
+			ops.relocate = [](void* dst, void* src) {
+				T* from = static_cast<T*>(src);
+				new (dst) T(std::move_if_noexcept(*from));
+				from->~T();
+			};
+			ops.swap = [](void* a, void* b) {
+				T* x = static_cast<T*>(a);
+				T* y = static_cast<T*>(b);
+				T tmp(std::move_if_noexcept(*x));
+				x->~T();
+				new (x) T(std::move_if_noexcept(*y));
+				y->~T();
+				new (y) T(std::move_if_noexcept(tmp));
+			};
+		}
+		if constexpr (!std::is_trivially_destructible_v<T>) {
+			ops.destroy = [](void* p) {
+				static_cast<T*>(p)->~T();
+			};
+		}
+		return ops;
+	}
+};
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ecs {
+
+/**
+ * @brief a whole file mapped into memory, copy-on-write:
+ * the mapping can be written to without changing the file
+ *
+ * @remarks uses mmap where available, and reads the file into memory elsewhere.
+ * the mapping starts on a system page boundary
+ */
+class mapped_file {
+public:
+	/**
+	 * @brief map the file at the given path
+	 *
+	 * @remarks throws if the file can't be opened or mapped
+	 */
+	mapped_file(const std::string& path);
+	~mapped_file();
+
+	mapped_file(const mapped_file& other) = delete;
+	mapped_file(mapped_file&& other)	  = delete;
+	mapped_file& operator=(const mapped_file& other) = delete;
+	mapped_file& operator=(mapped_file&& other) = delete;
+
+	/**
+	 * @return the start of the mapping
+	 */
+	char* data() const;
+
+	/**
+	 * @return the size (in bytes) of the file
+	 */
+	size_t size() const;
+
+private:
+	/// the start of the mapping
+	char* m_data;
+	/// the size of the file
+	size_t m_size;
+	/// true if m_data was mapped rather than allocated
+	bool m_mapped;
+};
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include <internal/entity_id.hpp>
+#include <internal/signature_set.hpp>
+#include <internal/sparse_set.hpp>
+
+namespace ecs {
+
+/**
+ * @brief the state of a cached query: the entities matching its required and excluded components,
+ * kept in a dense list the registry updates as the components it watches are added and removed
+ */
+class query_storage {
+public:
+	/**
+	 * @brief constructor, caching nothing yet
+	 *
+	 * @param required the components each entity must have
+	 * @param excluded the components no entity may have
+	 * @param signatures the signatures of the registry's entities, tested to tell if an entity matches
+	 * @param resource where to allocate the list of entities from
+	 */
+	query_storage(component_mask required, component_mask excluded, const signature_set& signatures,
+				  std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	query_storage(const query_storage& other) = delete;
+	query_storage(query_storage&& other)	  = delete;
+
+	/**
+	 * @return true if this query caches exactly the given terms
+	 */
+	bool caches(const component_mask& required, const component_mask& excluded) const;
+
+	/**
+	 * @return true if adding or removing the component with the given component_id can change what the query matches
+	 */
+	bool watches(size_t cid) const;
+
+	/**
+	 * @brief call after a watched component was added to or removed from an entity, and its signature updated.
+	 * adds the entity to the list if it now matches, removes it if it no longer does
+	 */
+	void update(entity_id id);
+
+	/**
+	 * @return the matching entities, in no particular order
+	 */
+	const std::pmr::vector<entity_id>& entities() const;
+
+	/**
+	 * @return how many entities match
+	 */
+	size_t size() const;
+
+	/**
+	 * @return true if the entity matches
+	 */
+	bool contains(entity_id id) const;
+
+private:
+	/// the components each entity must have
+	component_mask m_required;
+	/// the components no entity may have
+	component_mask m_excluded;
+	/// the signatures of the registry's entities
+	const signature_set* m_signatures;
+	/// the matching entities
+	sparse_set m_set;
+};
+
+}
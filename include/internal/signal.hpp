@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <internal/entity_id.hpp>
+
+namespace ecs {
+
+class registry;
+class entity;
+class observer;
+typedef entity entity_t;
+
+/**
+ * @brief the listeners of one event of one component type, called with the id of the entity it happened to
+ */
+class signal {
+public:
+	signal();
+
+	signal(const signal& other) = delete;
+	signal(signal&& other)		= delete;
+
+	/**
+	 * @brief add a listener
+	 *
+	 * @return an id to disconnect it with
+	 */
+	size_t connect(std::function<void(entity_id)> listener);
+
+	/**
+	 * @brief remove the listener with the given id, if still connected
+	 */
+	void disconnect(size_t id);
+
+	/**
+	 * @brief call every listener, in the order they were connected
+	 */
+	void emit(entity_id id) const {
+		for (size_t i = 0; i < m_listeners.size(); ++i) {
+			m_listeners[i].second(id);
+		}
+	}
+
+	/**
+	 * @return true if no listener is connected
+	 */
+	bool empty() const;
+
+private:
+	/// the listeners, with the ids they were connected under
+	std::vector<std::pair<size_t, std::function<void(entity_id)>>> m_listeners;
+	/// the id of the next listener
+	size_t m_next_id;
+};
+
+/**
+ * @brief where listeners of one event of a component type connect,
+ * e.g. registry::on_construct<Component>()
+ *
+ * @remarks listeners must not connect to or disconnect from the signal they are called by
+ */
+class sink {
+public:
+	sink(registry& r, signal& s);
+
+	/**
+	 * @brief call a function each time the event happens
+	 *
+	 * @param listener called with a handle to the entity the event happened to
+	 * @return an id to disconnect the listener with
+	 */
+	size_t connect(std::function<void(entity_t)> listener);
+
+	/**
+	 * @brief remove a listener added with connect()
+	 */
+	void disconnect(size_t id);
+
+	/**
+	 * @brief record the entities the event happens to into an observer, to handle them together later
+	 *
+	 * @remarks throws if the observer already collects from another registry
+	 */
+	void collect(observer& obs);
+
+private:
+	/// the registry the events happen in
+	registry* m_reg;
+	/// the signal of the event
+	signal* m_signal;
+};
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+#include <vector>
+
+#include <internal/component_id.hpp>
+
+namespace ecs {
+
+/**
+ * @brief a set of component types, one bit per component_id, to test signatures against.
+ * the first 64 ids fit in a single word, higher ones spill into a vector
+ */
+class component_mask {
+public:
+	/// how many component ids fit in the inline word
+	static constexpr size_t WORD_BITS = 64;
+
+	component_mask() = default;
+
+	/**
+	 * @brief a mask of the given component ids
+	 */
+	component_mask(std::initializer_list<size_t> cids);
+
+	/**
+	 * @brief the mask of the given component types
+	 */
+	template <typename... Components>
+	static component_mask of() {
+		return component_mask{ component_id<Components>()... };
+	}
+
+	/**
+	 * @brief add a component id to the mask
+	 */
+	void set(size_t cid);
+
+	/**
+	 * @return true if the component id is in the mask
+	 */
+	bool test(size_t cid) const;
+
+	/**
+	 * @return true if both masks have the same component ids
+	 */
+	bool operator==(const component_mask& other) const;
+
+	/**
+	 * @return the bits of the first 64 component ids
+	 */
+	uint64_t low() const {
+		return m_low;
+	}
+
+	/**
+	 * @return the bits of the component ids past the first 64, 64 per word
+	 */
+	const std::vector<uint64_t>& high() const {
+		return m_high;
+	}
+
+	/**
+	 * @return true if no component id is set
+	 */
+	bool empty() const;
+
+private:
+	/// the bits of the first 64 component ids
+	uint64_t m_low = 0;
+	/// the bits of the higher component ids, empty until one is set
+	std::vector<uint64_t> m_high;
+};
+
+/**
+ * @brief the signature of every entity: which component types it has, one bit per component_id, indexed by entity index.
+ * testing an entity against required and excluded types is an AND and a compare, instead of a lookup per pool
+ *
+ * @remarks the first 64 component ids are kept in one word per entity.
+ * the words for higher ids are only allocated once an entity gets such a component.
+ * signatures don't know entity generations: check the entity is alive first
+ */
+class signature_set {
+public:
+	/**
+	 * @brief constructor
+	 *
+	 * @param resource where to allocate the signatures from
+	 */
+	signature_set(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	/**
+	 * @brief mark the entity at an index as having a component type
+	 */
+	void set(size_t idx, size_t cid);
+
+	/**
+	 * @brief mark the entity at an index as not having a component type
+	 */
+	void reset(size_t idx, size_t cid);
+
+	/**
+	 * @return true if the entity at an index has a component type
+	 */
+	bool test(size_t idx, size_t cid) const;
+
+	/**
+	 * @return true if the entity at an index has every type of required, and none of excluded
+	 */
+	bool matches(size_t idx, const component_mask& required, const component_mask& excluded = {}) const {
+		uint64_t low = idx < m_low.size() ? m_low[idx] : 0;
+		if ((low & required.low()) != required.low() || (low & excluded.low()) != 0) return false;
+		return (required.high().empty() && excluded.high().empty()) || matches_high(idx, required, excluded);
+	}
+
+private:
+	/// matches() over the words of the component ids past the first 64
+	bool matches_high(size_t idx, const component_mask& required, const component_mask& excluded) const;
+
+	/// the bits of the first 64 component ids of each entity
+	std::pmr::vector<uint64_t> m_low;
+	/// the bits of the higher component ids, m_stride words per entity
+	std::pmr::vector<uint64_t> m_high;
+	/// how many words of m_high each entity has, 0 until a high component id is set
+	size_t m_stride;
+};
+
+}
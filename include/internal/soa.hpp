@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief the position of one field of a component stored as a structure of arrays
+ */
+struct soa_field {
+	/// the offset (in bytes) of the field in the component
+	size_t offset;
+	/// the size (in bytes) of the field
+	size_t size;
+};
+
+/**
+ * @brief the class and type of a pointer to data member
+ */
+template <typename T>
+struct member_traits;
+
+template <typename Class, typename Field>
+struct member_traits<Field Class::*> {
+	using class_type = Class;
+	using field_type = Field;
+};
+
+/**
+ * @brief true if both pointers to members point to the same member
+ */
+template <auto A, auto B>
+constexpr bool same_member() {
+	if constexpr (std::is_same_v<decltype(A), decltype(B)>) {
+		return A == B;
+	} else {
+		return false;
+	}
+}
+
+/**
+ * @brief the list of fields of a component stored as a structure of arrays,
+ * to derive soa_layout from, e.g.
+ * template <> struct ecs::soa_layout<position> : ecs::soa_fields<&position::x, &position::y> {};
+ *
+ * @tparam Fields pointers to every data member of the component
+ */
+template <auto First, auto... Rest>
+struct soa_fields {
+	using component = typename member_traits<decltype(First)>::class_type;
+
+	static_assert((true && ... && std::is_same_v<typename member_traits<decltype(Rest)>::class_type, component>),
+				  "every field must be a member of the same component");
+	static_assert(std::is_aggregate_v<component> && std::is_trivially_copyable_v<component>,
+				  "only aggregate, trivially copyable components can be stored as a structure of arrays");
+	static_assert((sizeof(typename member_traits<decltype(First)>::field_type) + ... +
+				   sizeof(typename member_traits<decltype(Rest)>::field_type)) <= sizeof(component),
+				  "a field is listed twice");
+
+	static constexpr bool enabled = true;
+	/// how many fields there are
+	static constexpr size_t count = 1 + sizeof...(Rest);
+
+	/**
+	 * @return the index of the field in the list, or count if it is not listed
+	 */
+	template <auto Field>
+	static constexpr size_t index_of() {
+		constexpr bool match[] = { same_member<Field, First>(), same_member<Field, Rest>()... };
+		for (size_t i = 0; i < count; ++i) {
+			if (match[i]) return i;
+		}
+		return count;
+	}
+
+	/**
+	 * @brief where each field sits in the component
+	 */
+	static std::vector<soa_field> fields() {
+		component c{};
+		const char* base = reinterpret_cast<const char*>(&c);
+		return {
+			soa_field{ size_t(reinterpret_cast<const char*>(&(c.*First)) - base), sizeof(c.*First) },
+			soa_field{ size_t(reinterpret_cast<const char*>(&(c.*Rest)) - base), sizeof(c.*Rest) }...
+		};
+	}
+};
+
+/**
+ * @brief opts a component into structure of arrays storage, one array per field, by deriving from soa_fields.
+ * components are stored whole, back to back, by default
+ *
+ * @remarks every field must be listed, any other byte of the component is not stored
+ */
+template <typename Component>
+struct soa_layout {
+	static constexpr bool enabled = false;
+};
+
+/**
+ * @brief true if the component is stored as a structure of arrays
+ */
+template <typename Component>
+constexpr bool is_soa_v = soa_layout<std::remove_const_t<Component>>::enabled;
+
+/**
+ * @brief the fields to split the component into, or none if it is stored whole
+ */
+template <typename Component>
+std::vector<soa_field> soa_fields_of() {
+	if constexpr (is_soa_v<Component>) {
+		return soa_layout<Component>::fields();
+	} else {
+		return {};
+	}
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include <internal/entity_id.hpp>
+
+namespace ecs {
+
+/**
+ * @brief a set of entity ids, stored packed in a dense array for iteration,
+ * alongside a sparse array mapping each id's index to its position in the dense array
+ *
+ * @remarks only one generation of an entity index can be in the set at a time.
+ * both arrays are allocated from the memory resource the set is given
+ */
+class sparse_set {
+public:
+	/// the sparse value of an id that is not in the set
+	static constexpr size_t npos = static_cast<size_t>(-1);
+	/// how many entity indices each page of the sparse array covers
+	static constexpr size_t PAGE_SZ = 4096;
+
+	/**
+	 * @brief constructor
+	 *
+	 * @param resource where to allocate the dense and sparse arrays from
+	 */
+	sparse_set(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	/**
+	 * @brief add an id to the end of the dense array
+	 *
+	 * @param id the id to add
+	 * @return the dense index of the id
+	 *
+	 * @remarks throws if the id is already in the set
+	 */
+	size_t insert(entity_id id);
+
+	/**
+	 * @brief remove an id from the set, moving the last id into its place
+	 *
+	 * @param id the id to remove
+	 *
+	 * @remarks throws if the id is not in the set
+	 */
+	void remove(entity_id id);
+
+	/**
+	 * @brief swap the ids at two positions of the dense array
+	 *
+	 * @remarks does not check bounds
+	 */
+	void swap(size_t a, size_t b);
+
+	/**
+	 * @return true if the id is in the set, with the same generation
+	 */
+	bool contains(entity_id id) const;
+
+	/**
+	 * @brief retrieve the position of an id in the dense array
+	 *
+	 * @remarks throws if the id is not in the set
+	 */
+	size_t index(entity_id id) const;
+
+	/**
+	 * @brief retrieve the position of an id in the dense array
+	 *
+	 * @return npos if the id is not in the set
+	 */
+	size_t find(entity_id id) const;
+
+	/**
+	 * @brief preallocate room in the dense array for n ids
+	 */
+	void reserve(size_t n);
+
+	/**
+	 * @brief release the room the dense array reserved past its size,
+	 * and the pages of the sparse array no id in the set falls into
+	 *
+	 * @return how many bytes were released
+	 */
+	size_t shrink_to_fit();
+
+	/**
+	 * @return how many ids are in the set
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief the packed array of ids in the set
+	 */
+	const std::pmr::vector<entity_id>& dense() const;
+
+private:
+	/// returns a page of the sparse array to the resource it came from
+	struct page_deleter {
+		std::pmr::memory_resource* resource;
+		void operator()(size_t* page) const;
+	};
+
+	/// the resource the arrays are allocated from
+	std::pmr::memory_resource* m_resource;
+	/// the packed ids
+	std::pmr::vector<entity_id> m_dense;
+	/// entity index -> index into m_dense, or npos. split into pages of PAGE_SZ indices,
+	/// only allocated once an id in their range is inserted
+	std::pmr::vector<std::unique_ptr<size_t[], page_deleter>> m_sparse;
+
+	/// the sparse entry of an id, allocating its page if necessary
+	size_t& assure(entity_id id);
+};
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+
+#include <internal/component_ref.hpp>
+
+namespace ecs {
+
+/**
+ * @brief declares the components a system only reads, e.g. reads<velocity>
+ */
+template <typename... Components>
+struct reads {};
+
+/**
+ * @brief declares the components a system modifies, e.g. writes<position>
+ */
+template <typename... Components>
+struct writes {};
+
+/**
+ * @brief the parameter types of a callable with a single, non-template call operator
+ */
+template <typename Fn>
+struct callable_args : callable_args<decltype(&std::remove_cvref_t<Fn>::operator())> {};
+
+template <typename R, typename... Args>
+struct callable_args<R (*)(Args...)> {
+	using type = std::tuple<Args...>;
+};
+
+template <typename R, typename... Args>
+struct callable_args<R(Args...)> {
+	using type = std::tuple<Args...>;
+};
+
+template <typename C, typename R, typename... Args>
+struct callable_args<R (C::*)(Args...)> {
+	using type = std::tuple<Args...>;
+};
+
+template <typename C, typename R, typename... Args>
+struct callable_args<R (C::*)(Args...) const> {
+	using type = std::tuple<Args...>;
+};
+
+/**
+ * @brief true if T is one of List's components
+ */
+template <typename T, typename List>
+struct declares;
+
+template <typename T, template <typename...> class List, typename... Components>
+struct declares<T, List<Components...>> : std::bool_constant<(false || ... || std::is_same_v<T, Components>)> {};
+
+/**
+ * @brief merges the components of every reads<> in Access into a single reads<>,
+ * and likewise for writes<>
+ */
+template <typename... Access>
+struct access_set;
+
+template <>
+struct access_set<> {
+	using read_t  = reads<>;
+	using write_t = writes<>;
+};
+
+template <typename... Components, typename... Rest>
+struct access_set<reads<Components...>, Rest...> {
+	template <typename... Others>
+	static reads<Components..., Others...> join(reads<Others...>);
+
+	using read_t  = decltype(join(typename access_set<Rest...>::read_t{}));
+	using write_t = typename access_set<Rest...>::write_t;
+};
+
+template <typename... Components, typename... Rest>
+struct access_set<writes<Components...>, Rest...> {
+	template <typename... Others>
+	static writes<Components..., Others...> join(writes<Others...>);
+
+	using read_t  = typename access_set<Rest...>::read_t;
+	using write_t = decltype(join(typename access_set<Rest...>::write_t{}));
+};
+
+/**
+ * @brief the component a parameter of a system accesses, and whether it may modify it
+ */
+template <typename Param, typename Decayed = std::remove_cvref_t<Param>>
+struct param_access {
+	using component			  = Decayed;
+	static constexpr bool mut = std::is_lvalue_reference_v<Param> && !std::is_const_v<std::remove_reference_t<Param>>;
+};
+
+template <typename Param, typename Component>
+struct param_access<Param, soa_ref<Component>> {
+	using component			  = Component;
+	static constexpr bool mut = true;
+};
+
+template <typename Param, typename Component>
+struct param_access<Param, soa_ref<const Component>> {
+	using component			  = Component;
+	static constexpr bool mut = false;
+};
+
+/**
+ * @brief checks one parameter of a system against the access the system declared:
+ * a mutable reference must be declared in writes<>, anything else in either reads<> or writes<>
+ */
+template <typename Param, typename Access>
+constexpr bool allowed_param() {
+	using component	   = typename param_access<Param>::component;
+	constexpr bool mut = param_access<Param>::mut;
+	constexpr bool written = declares<component, typename Access::write_t>::value;
+	constexpr bool read	   = declares<component, typename Access::read_t>::value;
+	return mut ? written : (written || read);
+}
+
+}
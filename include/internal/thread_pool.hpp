@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief a persistent set of worker threads running batches of tasks.
+ * each worker has its own queue, and steals from the others once it runs dry,
+ * so batches of uneven tasks still balance
+ */
+class thread_pool {
+public:
+	/**
+	 * @brief start the workers
+	 *
+	 * @param threads how many workers to start, one per hardware thread by default
+	 */
+	thread_pool(size_t threads = std::thread::hardware_concurrency());
+	~thread_pool();
+
+	thread_pool(const thread_pool& other) = delete;
+	thread_pool(thread_pool&& other)	  = delete;
+	thread_pool& operator=(const thread_pool& other) = delete;
+	thread_pool& operator=(thread_pool&& other) = delete;
+
+	/**
+	 * @brief runs task(i) for every i in [0, n) across the workers, blocking until all are done.
+	 * the calling thread works on the batch too, so this may be called from within a task
+	 *
+	 * @param n how many tasks to run
+	 * @param task the task to run, called concurrently
+	 *
+	 * @remarks rethrows the first exception thrown by a task, after the batch finishes
+	 */
+	void run(size_t n, const std::function<void(size_t)>& task);
+
+	/**
+	 * @return how many worker threads there are
+	 */
+	size_t size() const;
+
+	/**
+	 * @return the index of the calling thread if it is one of this pool's workers, otherwise size()
+	 */
+	size_t current_worker() const;
+
+private:
+	/// a call to run()
+	struct batch {
+		const std::function<void(size_t)>* task;
+		/// how many tasks have not finished yet
+		std::atomic<size_t> remaining;
+		/// signals the caller of run() once remaining reaches 0
+		std::mutex mtx;
+		std::condition_variable done;
+		/// the first exception thrown by a task
+		std::exception_ptr error;
+	};
+
+	/// one task of a batch
+	struct job {
+		batch* b;
+		size_t idx;
+	};
+
+	/// the queue of a worker. its owner takes from the back, thieves from the front
+	struct queue {
+		std::mutex mtx;
+		std::deque<job> jobs;
+	};
+
+	/// one queue per worker
+	std::vector<std::unique_ptr<queue>> m_queues;
+	/// the workers
+	std::vector<std::thread> m_threads;
+
+	/// how many jobs are queued, over all queues
+	std::atomic<size_t> m_queued;
+	/// guards sleeping workers
+	std::mutex m_sleep_mtx;
+	/// wakes up sleeping workers
+	std::condition_variable m_wake;
+	/// set to stop the workers
+	bool m_stop;
+
+	/// the main loop of the worker with the given index
+	void work(size_t self);
+
+	/**
+	 * @brief pop a job from the queue of the given worker, or steal one from another
+	 *
+	 * @param self the index of the calling worker, or m_queues.size() if it is not a worker
+	 * @return false if every queue is empty
+	 */
+	bool try_pop(size_t self, job& out);
+
+	/// run a job and mark it as finished
+	void execute(const job& j);
+
+	/// the index of the calling thread if it is one of this pool's workers, otherwise m_queues.size()
+	size_t self() const;
+};
+
+}
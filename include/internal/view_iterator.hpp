@@ -1,100 +1,204 @@
 #pragma once
 
+#include <internal/component_ref.hpp>
+#include <internal/signature_set.hpp>
+#include <internal/view_terms.hpp>
+
 #include <entity.hpp>
 #include <registry.hpp>
 
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <iterator>
 #include <stdexcept>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace ecs {
 
-template <typename... Components>
-class view;
-
 /**
  * @brief Iterates over a view's components
  *
- * @tparam Components the components that the view iterator runs through
+ * @tparam Required the components that the view iterator runs through
+ * @tparam Excluded the components of the entities to skip
+ * @tparam Optional the components handed out if the entity has them
+ *
+ * @remarks dereferencing yields a tuple of references by value, followed by a pointer to each optional component.
+ * iteration walks the packed arrays of the pool with the fewest components,
+ * skipping entities missing from the others or having an excluded component.
+ * a view of a single component excluding none has nothing to skip, so its iterator is random-access;
+ * otherwise the iterator is a forward iterator
  */
-template <typename Component, typename... Components>
-class view_iterator {
+template <typename Required, typename Excluded = type_list<>, typename Optional = type_list<>>
+class view_iterator;
+
+template <typename Component, typename... Components, typename... Excluded, typename... Optional>
+class view_iterator<type_list<Component, Components...>, type_list<Excluded...>, type_list<Optional...>> {
 public:
+	/// true if the iterator can jump, there being no other pools to filter by
+	static constexpr bool random_access = sizeof...(Components) == 0 && sizeof...(Excluded) == 0;
+
+	using value_type		= std::tuple<component_ref_t<Component>, component_ref_t<Components>..., Optional*...>;
+	using reference			= value_type;
+	using difference_type	= std::ptrdiff_t;
+	using iterator_category = std::conditional_t<random_access, std::random_access_iterator_tag, std::forward_iterator_tag>;
+	using iterator_concept	= iterator_category;
+
+	/**
+	 * @brief construct an iterator to nothing
+	 */
+	view_iterator()
+		: m_pools{},
+		  m_optional{},
+		  m_signatures(nullptr),
+		  m_required(),
+		  m_excludes(),
+		  m_driver(0),
+		  m_idx(0),
+		  m_end(0) {
+	}
+
 	/**
 	 * @brief construct the iterator
 	 *
 	 * @param reg the registry this iterates over
+	 * @param end true to point past the last matching entity
 	 */
-	view_iterator(registry& reg, size_t idx)
-		: m_reg(reg),
-		  m_entity_count(reg.count()) {
-		if (idx >= reg.count()) {
-			m_iter = m_reg.entities().end();
-		} else {
-			m_iter = m_reg.entities().begin();
-			do {
-				filter_increment();
-			} while (idx-- > 0);
+	view_iterator(registry& reg, bool end)
+		: m_pools{ reg.template find_pool<Component>(),
+				   reg.template find_pool<Components>()... },
+		  m_optional{ reg.template find_pool<Optional>()... },
+		  m_signatures(&reg.signatures()),
+		  m_required(component_mask::of<Component, Components...>()),
+		  m_excludes(component_mask::of<Excluded...>()),
+		  m_driver(0),
+		  m_idx(0),
+		  m_end(0) {
+		if (std::find(m_pools.begin(), m_pools.end(), nullptr) == m_pools.end()) {
+			for (size_t i = 1; i < m_pools.size(); ++i) {
+				if (m_pools[i]->count() < m_pools[m_driver]->count()) m_driver = i;
+			}
+			m_end = m_pools[m_driver]->count();
 		}
-		compute_tuple();
+		m_idx = end ? m_end : 0;
+		filter_increment();
 	}
 
 	/// dereferencing
-	std::tuple<Component&, Components&...>& operator*() {
-		return *m_tuple;
-	}
-	std::tuple<Component&, Components&...>* operator->() {
-		return m_tuple.get();
+	reference operator*() const {
+		return at(m_idx);
 	}
 
 	/// increment
-	view_iterator<Component, Components...>& operator++() {
+	view_iterator& operator++() {
 		// iterate while making sure that the entity selected has the components necessary
-		++m_iter;
+		++m_idx;
 		filter_increment();
-		compute_tuple();
 		return *this;
 	}
-	view_iterator<Component, Components...> operator++(int) {
-		view_iterator<Component, Components...> tmp = *this;
+	view_iterator operator++(int) {
+		view_iterator tmp = *this;
 		++(*this);
-		compute_tuple();
 		return tmp;
 	}
 
+	/// random access, only over the packed array of a single component
+	view_iterator& operator--() requires random_access {
+		--m_idx;
+		return *this;
+	}
+	view_iterator operator--(int) requires random_access {
+		view_iterator tmp = *this;
+		--m_idx;
+		return tmp;
+	}
+	view_iterator& operator+=(difference_type n) requires random_access {
+		m_idx += n;
+		return *this;
+	}
+	view_iterator& operator-=(difference_type n) requires random_access {
+		m_idx -= n;
+		return *this;
+	}
+	reference operator[](difference_type n) const requires random_access {
+		return at(m_idx + n);
+	}
+	friend view_iterator operator+(view_iterator a, difference_type n) requires random_access {
+		return a += n;
+	}
+	friend view_iterator operator+(difference_type n, view_iterator a) requires random_access {
+		return a += n;
+	}
+	friend view_iterator operator-(view_iterator a, difference_type n) requires random_access {
+		return a -= n;
+	}
+	friend difference_type operator-(const view_iterator& a,
+									 const view_iterator& b) requires random_access {
+		return difference_type(a.m_idx) - difference_type(b.m_idx);
+	}
+	friend std::strong_ordering operator<=>(const view_iterator& a,
+											const view_iterator& b) requires random_access {
+		return a.m_idx <=> b.m_idx;
+	}
+
 	/// equality
-	friend bool operator==(const view_iterator<Component, Components...>& a,
-						   const view_iterator<Component, Components...>& b) {
-		return a.m_iter == b.m_iter;
+	friend bool operator==(const view_iterator& a,
+						   const view_iterator& b) {
+		return a.m_idx == b.m_idx;
 	}
-	friend bool operator!=(const view_iterator<Component, Components...>& a,
-						   const view_iterator<Component, Components...>& b) {
+	friend bool operator!=(const view_iterator& a,
+						   const view_iterator& b) {
 		return !(a == b);
 	}
 
 private:
-	/// internal registry
-	registry& m_reg;
-	/// how many entities were there when this iterator was initialized
-	const int m_entity_count;
-	/// registry entity list iterator
-	std::list<entity_t>::iterator m_iter;
-	/// the current tuple of components we are at
-	std::unique_ptr<std::tuple<Component&, Components&...>> m_tuple;
-	/// compute the current tuple given m_idx
-	void compute_tuple() {
-		if (m_iter == m_reg.entities().end()) return;
-		entity_t ent = *m_iter;
-		m_tuple.reset(
-			new std::tuple<Component&, Components&...>(
-				ent->get<Component>(),
-				ent->get<Components>()...));
+	/// the pools of each component
+	std::array<component_pool*, 1 + sizeof...(Components)> m_pools;
+	/// the pools of each optional component, nullptr if there is none
+	std::array<component_pool*, sizeof...(Optional)> m_optional;
+	/// the signatures of the registry's entities
+	const signature_set* m_signatures;
+	/// the required component types
+	component_mask m_required;
+	/// the excluded component types
+	component_mask m_excludes;
+	/// index of the pool with the fewest components, driving the iteration
+	size_t m_driver;
+	/// index into the packed arrays of the driving pool
+	size_t m_idx;
+	/// size of the packed arrays of the driving pool
+	size_t m_end;
+	/// the tuple of components at an index of the driving pool
+	reference at(size_t idx) const {
+		entity_id id = m_pools[m_driver]->entities()[idx];
+		return [&]<size_t... I, size_t... J>(std::index_sequence<I...>, std::index_sequence<J...>) {
+			return reference(
+				fetch<Component, 0>(idx, id),
+				fetch<Components, I + 1>(idx, id)...,
+				component_ptr<Optional>(m_optional[J], id)...);
+		}
+		(std::index_sequence_for<Components...>{}, std::index_sequence_for<Optional...>{});
+	}
+	/// the component of the I-th pool, read directly at the packed index if it is the driving pool
+	template <typename C, size_t I>
+	component_ref_t<C> fetch(size_t idx, entity_id id) const {
+		return component_ref<C>(m_pools[I], I == m_driver ? idx : m_pools[I]->index(id));
 	}
 	/// checks if the current element is valid. if not, increments until end(), or until a valid element is found
 	void filter_increment() {
-		while (m_iter != m_reg.entities().end() && !(*m_iter)->has<Component, Components...>()) {
-			m_iter++;
+		if constexpr (!random_access) {
+			while (m_idx != m_end && !has_all(m_pools[m_driver]->entities()[m_idx])) {
+				m_idx++;
+			}
 		}
 	}
+	/// true if the entity has every required component and no excluded one, tested on its signature
+	bool has_all(entity_id id) const {
+		return m_signatures->matches(entity_index(id), m_required, m_excludes);
+	}
 };
 
 }
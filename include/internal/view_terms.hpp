@@ -0,0 +1,92 @@
+#pragma once
+
+#include <type_traits>
+
+namespace ecs {
+
+/**
+ * @brief a term of a view keeping out the entities having any of the components,
+ * e.g. view<position, velocity, exclude<frozen>>
+ */
+template <typename... Components>
+struct exclude {};
+
+/**
+ * @brief a term of a view handing out the components if the entity has them, as pointers that are nullptr otherwise,
+ * e.g. view<mesh, optional<tint>>
+ */
+template <typename... Components>
+struct optional {};
+
+/**
+ * @brief a list of types
+ */
+template <typename... Types>
+struct type_list {};
+
+/**
+ * @brief true if T is one of the types of a list, e.g. a type_list
+ */
+template <typename T, typename List>
+constexpr bool in_list_v = false;
+
+template <typename T, template <typename...> class List, typename... Types>
+constexpr bool in_list_v<T, List<Types...>> = (false || ... || std::is_same_v<T, Types>);
+
+/**
+ * @brief the types of several type_lists, in order
+ */
+template <typename... Lists>
+struct concat {
+	using type = type_list<>;
+};
+
+template <typename... Types>
+struct concat<type_list<Types...>> {
+	using type = type_list<Types...>;
+};
+
+template <typename... A, typename... B, typename... Rest>
+struct concat<type_list<A...>, type_list<B...>, Rest...> {
+	using type = typename concat<type_list<A..., B...>, Rest...>::type;
+};
+
+template <typename... Lists>
+using concat_t = typename concat<Lists...>::type;
+
+/**
+ * @brief what one term of a view contributes to its required, excluded and optional components
+ */
+template <typename Term>
+struct view_term {
+	using required = type_list<Term>;
+	using excluded = type_list<>;
+	using optional = type_list<>;
+};
+
+template <typename... Components>
+struct view_term<exclude<Components...>> {
+	using required = type_list<>;
+	using excluded = type_list<Components...>;
+	using optional = type_list<>;
+};
+
+template <typename... Components>
+struct view_term<ecs::optional<Components...>> {
+	using required = type_list<>;
+	using excluded = type_list<>;
+	using optional = type_list<Components...>;
+};
+
+/**
+ * @brief the terms of a view, split into the components it requires, excludes and hands out if present,
+ * each in the order they are listed
+ */
+template <typename... Terms>
+struct view_terms {
+	using required = concat_t<typename view_term<Terms>::required...>;
+	using excluded = concat_t<typename view_term<Terms>::excluded...>;
+	using optional = concat_t<typename view_term<Terms>::optional...>;
+};
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <internal/entity_id.hpp>
+#include <internal/signal.hpp>
+
+#include <entity.hpp>
+#include <registry.hpp>
+
+namespace ecs {
+
+/**
+ * @brief collects the entities events happen to, e.g. every entity whose position was patched,
+ * into a buffer that is drained once per frame instead of reacting to each event as it happens
+ *
+ * @remarks connect it with sink::collect(). each entity is recorded once until the observer is cleared.
+ * the buffer keeps its memory across clears.
+ * if it outlives the registry it collects from, the registry disconnects it when destroyed,
+ * after which its entities must not be visited
+ */
+class observer {
+public:
+	observer();
+	~observer();
+
+	observer(const observer& other) = delete;
+	observer(observer&& other)		= delete;
+	observer& operator=(const observer& other) = delete;
+	observer& operator=(observer&& other) = delete;
+
+	/**
+	 * @brief runs a callback on each entity recorded, in the order they were first recorded
+	 *
+	 * @param callback any callable taking an entity_t, which may no longer be alive, e.g. after on_destroy()
+	 */
+	template <typename Fn>
+	void each(Fn&& callback) const {
+		for (entity_id id : m_ids) {
+			callback(m_reg->handle(id));
+		}
+	}
+
+	/**
+	 * @brief runs a callback on each entity recorded, then forgets them
+	 *
+	 * @param callback see each()
+	 */
+	template <typename Fn>
+	void drain(Fn&& callback) {
+		each(callback);
+		clear();
+	}
+
+	/**
+	 * @brief the ids of the entities recorded, in the order they were first recorded
+	 */
+	const std::vector<entity_id>& entities() const;
+
+	/**
+	 * @return how many entities were recorded
+	 */
+	size_t size() const;
+
+	/**
+	 * @return true if no entity was recorded
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief forget the entities recorded
+	 */
+	void clear();
+
+	/**
+	 * @brief stop collecting from every sink, and forget the entities recorded,
+	 * so the observer can collect from another registry
+	 */
+	void disconnect();
+
+private:
+	friend class sink;
+	friend class registry;
+
+	/// record an entity, unless already recorded
+	void record(entity_id id);
+
+	/// the registry the entities are in
+	registry* m_reg;
+	/// the entities recorded
+	std::vector<entity_id> m_ids;
+	/// entity index -> position in m_ids of its latest generation, or npos
+	std::vector<size_t> m_slot;
+	/// the signals collected from, and the id of the listener in each
+	std::vector<std::pair<signal*, size_t>> m_connections;
+};
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include <internal/component_pool.hpp>
+#include <internal/component_ref.hpp>
+#include <internal/query_storage.hpp>
+#include <internal/view_terms.hpp>
+
+#include <entity.hpp>
+#include <registry.hpp>
+
+namespace ecs {
+
+/**
+ * @brief what a query does, over its terms split into the components it requires, excludes and hands out if present.
+ * use query<Terms...>, which splits the terms
+ */
+template <typename Required, typename Excluded, typename Optional>
+class basic_query;
+
+template <typename... Components, typename... Excluded, typename... Optional>
+class basic_query<type_list<Components...>, type_list<Excluded...>, type_list<Optional...>> {
+public:
+	/**
+	 * @brief runs a callback on each entity matching the query, walking only the cached list of them
+	 *
+	 * @param callback any callable taking either (entity_t, Components&..., Optional*...) or (Components&..., Optional*...)
+	 */
+	template <typename Fn>
+	void each(Fn&& callback) {
+		static_assert(std::is_invocable_v<Fn&, entity_t, component_ref_t<Components>..., Optional*...> ||
+						  std::is_invocable_v<Fn&, component_ref_t<Components>..., Optional*...>,
+					  "each() callback must take (entity_t, Components&..., Optional*...) or (Components&..., Optional*...)");
+		if (m_storage->size() == 0) return;
+		std::array<component_pool*, sizeof...(Components)> pools{ m_reg->template find_pool<Components>()... };
+		std::array<component_pool*, sizeof...(Optional)> optional{ m_reg->template find_pool<Optional>()... };
+		const std::pmr::vector<entity_id>& ents = m_storage->entities();
+		for (size_t i = 0; i < ents.size(); ++i) {
+			entity_id id = ents[i];
+			[&]<size_t... I, size_t... J>(std::index_sequence<I...>, std::index_sequence<J...>) {
+				if constexpr (std::is_invocable_v<Fn&, entity_t, component_ref_t<Components>..., Optional*...>) {
+					callback(m_reg->handle(id), component_ref<Components>(pools[I], pools[I]->index(id))...,
+							 component_ptr<Optional>(optional[J], id)...);
+				} else {
+					callback(component_ref<Components>(pools[I], pools[I]->index(id))..., component_ptr<Optional>(optional[J], id)...);
+				}
+			}
+			(std::index_sequence_for<Components...>{}, std::index_sequence_for<Optional...>{});
+		}
+	}
+
+	/**
+	 * @return how many entities match the query
+	 */
+	size_t size() const {
+		return m_storage->size();
+	}
+
+	/**
+	 * @return true if the entity matches the query
+	 */
+	bool contains(const entity_t& e) const {
+		return e == m_reg->handle(e.id()) && m_storage->contains(e.id());
+	}
+
+	/**
+	 * @return the ids of the entities matching the query, in no particular order
+	 */
+	std::span<const entity_id> entities() const {
+		return m_storage->entities();
+	}
+
+protected:
+	/**
+	 * @brief can only be instantiated by the registry api
+	 */
+	basic_query(registry& r, query_storage& storage)
+		: m_reg(&r),
+		  m_storage(&storage) {
+	}
+
+private:
+	/// the registry this query originates from
+	registry* m_reg;
+	/// which entities match the query
+	query_storage* m_storage;
+};
+
+/**
+ * @brief a persistent query, caching the list of the entities matching its terms.
+ * the registry updates the list as the components it lists are added and removed,
+ * so walking it costs nothing for the entities that don't match
+ *
+ * @tparam Terms the components each entity must have, and exclude<...> or optional<...> terms, as for a view
+ *
+ * @remarks adding or removing the components a query lists reorders its list:
+ * don't do so in a callback, defer it with a command_buffer
+ */
+template <typename... Terms>
+class query : public basic_query<typename view_terms<Terms...>::required, typename view_terms<Terms...>::excluded,
+								 typename view_terms<Terms...>::optional> {
+	/// what the query does
+	using base = basic_query<typename view_terms<Terms...>::required, typename view_terms<Terms...>::excluded,
+							 typename view_terms<Terms...>::optional>;
+
+private:
+	friend class registry;
+
+	/**
+	 * @brief can only be instantiated by the registry api
+	 */
+	query(registry& r, query_storage& storage)
+		: base(r, storage) {
+	}
+};
+
+}
@@ -1,22 +1,50 @@
 #pragma once
 
 #include <algorithm>
-#include <list>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <iterator>
 #include <memory>
-#include <range/v3/all.hpp>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <type_traits>
 #include <typeindex>
 #include <typeinfo>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <internal/component_id.hpp>
 #include <internal/component_pool.hpp>
+#include <internal/component_ref.hpp>
+#include <internal/entity_id.hpp>
+#include <internal/group_storage.hpp>
+#include <internal/mapped_file.hpp>
+#include <internal/query_storage.hpp>
+#include <internal/signal.hpp>
+#include <internal/signature_set.hpp>
+#include <internal/sparse_set.hpp>
+#include <internal/thread_pool.hpp>
+#include <internal/view_terms.hpp>
 
 namespace ecs {
 
 class entity;
 template <typename... Components>
 class view;
-typedef std::shared_ptr<entity> entity_t;
+template <typename Required, typename Excluded, typename Optional>
+class basic_view;
+template <typename... Owned>
+class group;
+template <typename... Terms>
+class query;
+template <typename Required, typename Excluded, typename Optional>
+class basic_query;
+typedef entity entity_t;
 
 /**
  * @brief registry of entities and their components
@@ -27,9 +55,12 @@ public:
 	/**
 	 * @brief constructor
 	 *
-	 * @param max_components the maximum amount of each type of component
+	 * @param max_components optional hard cap on the amount of each type of component,
+	 * pools grow on demand without one
+	 * @param resource where to allocate the component pools and the entity records from,
+	 * e.g. an arena_resource. must outlive the registry
 	 */
-	registry(size_t max_components = 1024);
+	registry(size_t max_components = component_pool::unlimited, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 	~registry();
 
 	registry(const registry& other) = delete;
@@ -43,17 +74,253 @@ public:
 	entity_t create();
 
 	/**
-	 * @brief removes an entity from the registry
+	 * @brief creates an entity with the given id, e.g. to mirror the entities of another registry
+	 *
+	 * @remarks throws if an entity with the same index is in the registry
+	 */
+	entity_t create(entity_id id);
+
+	/**
+	 * @brief creates many entities at once
+	 *
+	 * @param n how many entities to create
+	 * @param out where to write the handles of the new entities
+	 * @return the output iterator, past the last handle written
+	 *
+	 * @remarks throws before creating any entity if there aren't n ids left
+	 */
+	template <typename OutputIt>
+	OutputIt create_many(size_t n, OutputIt out) {
+		if (n > m_free_ids.size() + (ENTITY_INDEX_MASK - m_next_index)) {
+			throw std::out_of_range("Too many entities in the registry.");
+		}
+		m_entities.reserve(m_entities.size() + n);
+		for (size_t i = 0; i < n; ++i) {
+			*out++ = create();
+		}
+		return out;
+	}
+
+	/**
+	 * @brief removes an entity from the registry, along with all its components
 	 *
 	 * @param e the entity to remove
 	 */
 	void remove(entity_t e);
 
+	/**
+	 * @brief gives every entity of a range a copy of the same component,
+	 * growing the pool once for all of them
+	 *
+	 * @param first the first entity of the range
+	 * @param last past the last entity of the range
+	 * @param value the component to copy
+	 *
+	 * @remarks throws before adding any component if an entity is not in the registry, already has one,
+	 * or is listed twice
+	 */
+	template <typename Component, std::forward_iterator EntityIt>
+	void insert(EntityIt first, EntityIt last, const Component& value = {}) {
+		component_pool& pool = prepare_insert<Component>(first, last);
+		for (; first != last; ++first) {
+			pool.add<Component>(first->id(), value);
+			added(component_id<Component>(), first->id());
+		}
+	}
+
+	/**
+	 * @brief gives every entity of a range its own component,
+	 * growing the pool once for all of them
+	 *
+	 * @param first the first entity of the range
+	 * @param last past the last entity of the range
+	 * @param from the first of the components, parallel to the entities
+	 *
+	 * @remarks throws before adding any component if an entity is not in the registry, already has one,
+	 * or is listed twice
+	 */
+	template <typename Component, std::forward_iterator EntityIt, std::input_iterator ComponentIt>
+	void insert(EntityIt first, EntityIt last, ComponentIt from) {
+		component_pool& pool = prepare_insert<Component>(first, last);
+		for (; first != last; ++first, ++from) {
+			pool.add<Component>(first->id(), *from);
+			added(component_id<Component>(), first->id());
+		}
+	}
+
+	/**
+	 * @return true if the id belongs to an entity currently in the registry
+	 */
+	bool valid(entity_id id) const;
+
 	/**
 	 * @return how many entities are registered
 	 */
 	size_t count() const;
 
+	/**
+	 * @brief preallocate room for n components of the given type
+	 *
+	 * @tparam Component the type of component to make room for
+	 * @param n the amount of components the pool should fit without growing
+	 *
+	 * @remarks throws if n exceeds the maximum amount of components
+	 */
+	template <typename Component>
+	void reserve(size_t n) {
+		assure<Component>().reserve(n);
+	}
+
+	/**
+	 * @brief defragment every pool: sort its components by entity index, so views over several
+	 * components walk their pools in the same direction, then release the memory no component uses anymore
+	 *
+	 * @return how many bytes were released
+	 *
+	 * @remarks the pools owned by a group keep their order, and are only shrunk.
+	 * invalidates references to components
+	 */
+	size_t compact();
+
+	/**
+	 * @brief defragment the pool of the given type, see compact()
+	 *
+	 * @return how many bytes were released
+	 */
+	template <typename Component>
+	size_t compact() {
+		size_t cid = component_id<Component>();
+		return cid < m_components.size() && m_components[cid] ? compact_pool(cid) : 0;
+	}
+
+	/**
+	 * @brief defragment the pools a bit at a time, e.g. once per frame:
+	 * picks up where the previous call stopped, moving at most max_moves components.
+	 * a pool is shrunk once it is sorted. see compact()
+	 *
+	 * @param max_moves how many positions of the packed arrays to arrange at most, each costing at most one swap
+	 * @return how many bytes were released
+	 *
+	 * @remarks sorting a pool starts by copying and sorting its entity ids, which is not spread across calls.
+	 * entities added or removed in between make the pool start over
+	 */
+	size_t compact(size_t max_moves);
+
+	/**
+	 * @brief stamp the components of the given type with the tick they are added and changed in,
+	 * so views can keep only those added or changed since a tick, see view::changed() and view::added()
+	 *
+	 * @remarks a component counts as changed whenever a mutable reference to it is handed out,
+	 * e.g. by entity::get(), entity::patch() or a non-const view.
+	 * the components the type already has are stamped with tick 0
+	 */
+	template <typename Component>
+	void track() {
+		assure<Component>().track(&m_tick);
+	}
+
+	/**
+	 * @return the current tick, which additions and changes are stamped with. the first tick is 1
+	 */
+	uint64_t tick() const;
+
+	/**
+	 * @brief start a new tick
+	 *
+	 * @return the tick that ended: changes made from now on are after it,
+	 * e.g. to pass to view::changed() the next time a system runs
+	 */
+	uint64_t advance_tick();
+
+	/**
+	 * @brief the event of a component of the given type being added to an entity,
+	 * signaled right after, including when an entity is cloned or loaded from a snapshot
+	 */
+	template <typename Component>
+	sink on_construct() {
+		return sink(*this, assure_signals(component_id<Component>()).construct);
+	}
+
+	/**
+	 * @brief the event of a component of the given type being removed from an entity,
+	 * signaled right before, including when the entity is removed from the registry
+	 */
+	template <typename Component>
+	sink on_destroy() {
+		return sink(*this, assure_signals(component_id<Component>()).destroy);
+	}
+
+	/**
+	 * @brief the event of a component of the given type being modified with entity::patch(), signaled right after
+	 */
+	template <typename Component>
+	sink on_update() {
+		return sink(*this, assure_signals(component_id<Component>()).update);
+	}
+
+	/**
+	 * @brief name a plain-data component type for snapshots. its pool is saved as raw pages,
+	 * which load_mapped() uses straight from the file
+	 *
+	 * @param name a name unique among the registered types, which must stay the same across builds
+	 *
+	 * @remarks throws if the name is taken by another type
+	 */
+	template <typename Component>
+	void register_component(std::string name) {
+		static_assert(std::is_trivially_copyable_v<Component>, "a component that isn't trivially copyable needs snapshot hooks");
+		auto [page_bytes, page_align] = component_pool::page_layout(sizeof(Component), soa_fields_of<Component>(), alignof(Component));
+		register_snapshot(component_id<Component>(), snapshot_type{ std::move(name), true, &assure_pool<Component>, &emplace_raw<Component>, nullptr, nullptr,
+																	sizeof(Component), page_bytes, page_align });
+	}
+
+	/**
+	 * @brief name a component type for snapshots, saving and loading each component with the given hooks
+	 *
+	 * @param name a name unique among the registered types, which must stay the same across builds
+	 * @param save writes a component to the stream
+	 * @param load reads back a component written by save
+	 *
+	 * @remarks throws if the name is taken by another type
+	 */
+	template <typename Component>
+	void register_component(std::string name,
+							std::function<void(const Component&, std::ostream&)> save,
+							std::function<Component(std::istream&)> load) {
+		static_assert(!is_soa_v<Component>, "components stored as a structure of arrays are saved as raw pages");
+		snapshot_type type{ std::move(name), false, &assure_pool<Component>, nullptr, nullptr, nullptr, 0, 0, 0 };
+		type.save = [save = std::move(save)](const component_pool& p, std::ostream& out) {
+			for (size_t i = 0; i < p.count(); ++i) {
+				save(*p.at<Component>(i), out);
+			}
+		};
+		type.load = [load = std::move(load)](registry& r, const entity_id* ids, size_t n, std::istream& in) {
+			r.reserve<Component>(n);
+			for (size_t i = 0; i < n; ++i) {
+				r.add<Component>(ids[i], load(in));
+			}
+		};
+		register_snapshot(component_id<Component>(), std::move(type));
+	}
+
+	/**
+	 * @brief write every entity and component to a binary snapshot file
+	 *
+	 * @remarks throws if a type of component any entity has was not registered
+	 */
+	void save(const std::string& path) const;
+
+	/**
+	 * @brief fill the registry with the entities and components of a snapshot written by save(),
+	 * mapping the file into memory. pools of plain-data components use the file's pages
+	 * rather than copying them, and pages are only copied once modified
+	 *
+	 * @remarks the registry must be empty, without groups, and have every type of the snapshot registered.
+	 * throws before changing the registry if that is not so, or if the snapshot was written
+	 * by another version, or with components of a different layout
+	 */
+	void load_mapped(const std::string& path);
+
 	/**
 	 * @brief retrieves a view of all entites with the component(s) listed
 	 *
@@ -75,14 +342,45 @@ public:
 	}
 
 	/**
-	 * @brief retrieve all entities
+	 * @brief retrieves an owning group of the component(s) listed.
+	 * the group takes ownership of their pools, keeping the entities having all of them
+	 * packed at the front of each pool, in the same order, so iterating it needs no lookups
+	 *
+	 * @tparam Owned the components of the group
+	 *
+	 * @remarks throws if one of the pools is already owned by a different group.
+	 * retrieving the same group again is cheap
 	 */
-	std::list<entity_t>& entities();
+	template <typename... Owned>
+	ecs::group<Owned...> group() {
+		static_assert(sizeof...(Owned) > 0, "a group must own at least one component");
+		group_storage& s = assure_group({ component_id<Owned>()... }, { &assure<Owned>()... });
+		return ecs::group<Owned...>(*this, s);
+	}
+
+	/**
+	 * @brief retrieves a cached query of the terms listed. the registry keeps the list of the entities matching them
+	 * up to date as their components are added and removed, so walking it never looks at an entity that doesn't match
+	 *
+	 * @tparam Terms the components each entity must have, and exclude<...> or optional<...> terms, as for view()
+	 *
+	 * @remarks retrieving the same query again is cheap. every query slows down adding and removing the components it lists
+	 */
+	template <typename... Terms>
+	ecs::query<Terms...> query() {
+		query_storage& s = assure_query<typename view_terms<Terms...>::required, typename view_terms<Terms...>::excluded>();
+		return ecs::query<Terms...>(*this, s);
+	}
 
 	/**
-	 * @brief retrieve all entities
+	 * @brief retrieve the ids of all entities, packed
 	 */
-	const std::list<entity_t>& entities() const;
+	const std::pmr::vector<entity_id>& entities() const;
+
+	/**
+	 * @brief the memory resource the pools and entity records are allocated from
+	 */
+	std::pmr::memory_resource* resource() const;
 
 	/**
 	 * @brief retrieve the pool saving the components of the given type
@@ -94,69 +392,406 @@ public:
 	 */
 	const component_pool& pool(std::type_index ti) const;
 
+	/**
+	 * @brief retrieve the pool saving the components of the given type
+	 *
+	 * @return nullptr if no component of that type was ever added
+	 */
+	component_pool* find_pool(std::type_index ti);
+
+	/**
+	 * @brief retrieve the pool saving the components of the given type
+	 *
+	 * @return nullptr if no component of that type was ever added
+	 */
+	const component_pool* find_pool(std::type_index ti) const;
+
+	/**
+	 * @brief retrieve the pool saving the components of the given type
+	 *
+	 * @return nullptr if no component of that type was ever added
+	 */
+	template <typename Component>
+	component_pool* find_pool() {
+		size_t cid = component_id<Component>();
+		return cid < m_components.size() ? m_components[cid].get() : nullptr;
+	}
+
+	/**
+	 * @brief retrieve the pool saving the components of the given type
+	 *
+	 * @return nullptr if no component of that type was ever added
+	 */
+	template <typename Component>
+	const component_pool* find_pool() const {
+		size_t cid = component_id<Component>();
+		return cid < m_components.size() ? m_components[cid].get() : nullptr;
+	}
+
+	/**
+	 * @brief which component types each entity has, to test an entity against several types at once
+	 *
+	 * @remarks indexed by entity index: check the entity is alive first
+	 */
+	const signature_set& signatures() const {
+		return m_signatures;
+	}
+
+	/**
+	 * @brief the thread pool running parallel iteration over this registry,
+	 * started on first use with one worker per hardware thread unless one was given with use_workers()
+	 */
+	thread_pool& workers() const;
+
+	/**
+	 * @brief run parallel iteration over this registry on the given thread pool,
+	 * e.g. to share one pool between registries
+	 */
+	void use_workers(std::shared_ptr<thread_pool> pool);
+
+	/**
+	 * @brief retrieve a handle to an entity given its id
+	 *
+	 * @param id the id of the entity, as stored in the component pools
+	 *
+	 * @remarks throws if the entity is not in the registry
+	 */
+	entity_t at(entity_id id) const;
+
 private:
 	friend class entity;
+	template <typename... Components>
+	friend class view;
+	template <typename Required, typename Excluded, typename Optional>
+	friend class basic_view;
+	template <typename... Owned>
+	friend class group;
+	template <typename Required, typename Excluded, typename Optional>
+	friend class basic_query;
+	friend class delta_encoder;
+	friend class delta_decoder;
+	friend class sink;
+	friend class observer;
+
+	/**
+	 * @brief add an id to the ids to reuse
+	 */
+	void push_free(entity_id id);
+
+	/**
+	 * @brief remove the id at a position of the ids to reuse, moving the last one into its place
+	 *
+	 * @return the removed id
+	 */
+	entity_id take_free(size_t slot);
+
+	/// the events of a component type
+	struct component_signals {
+		signal construct;
+		signal destroy;
+		signal update;
+	};
+
+	/**
+	 * @brief retrieve the signals of the given component_id, constructing them if they do not exist
+	 */
+	component_signals& assure_signals(size_t cid);
+
+	/// how to save and load the components of a type registered for snapshots
+	struct snapshot_type {
+		/// the stable name of the type
+		std::string name;
+		/// true if the pool is saved as raw pages
+		bool raw;
+		/// retrieves the pool of the type, constructing it if it does not exist
+		component_pool& (*assure)(registry&);
+		/// gives an entity a component copied from its raw bytes, if raw
+		void (*emplace)(registry&, entity_id, const char*);
+		/// writes each component of the pool, unless raw
+		std::function<void(const component_pool&, std::ostream&)> save;
+		/// gives each entity a component read from the stream, unless raw
+		std::function<void(registry&, const entity_id*, size_t, std::istream&)> load;
+		/// the size (in bytes) of each component, if raw, so deltas can be checked without constructing the pool
+		size_t size;
+		/// the page_bytes() of the pool, if raw, so snapshots can be checked without constructing it
+		size_t page_bytes;
+		/// the page_align() of the pool, if raw
+		size_t page_align;
+	};
+
+	/**
+	 * @brief register a type for snapshots
+	 *
+	 * @remarks throws if the name is taken by another type
+	 */
+	void register_snapshot(size_t cid, snapshot_type type);
+
+	/// retrieve the pool of the given component type, constructing it if it does not exist
+	template <typename Component>
+	static component_pool& assure_pool(registry& r) {
+		return r.assure<Component>();
+	}
+
+	/// give an entity a component copied from its raw bytes, unaligned
+	template <typename Component>
+	static void emplace_raw(registry& r, entity_id id, const char* bytes) {
+		alignas(Component) unsigned char buf[sizeof(Component)];
+		std::memcpy(buf, bytes, sizeof(Component));
+		r.add<Component>(id, *std::launder(reinterpret_cast<Component*>(buf)));
+	}
+
+	/**
+	 * @brief a handle to the entity with the given id, without checking that it is alive
+	 *
+	 * @remarks like a pointer to a non-const entity, a handle does not carry the constness of its registry
+	 */
+	entity_t handle(entity_id id) const;
 
 	const size_t MAX_COMPONENTS;   /// max amount of each type of component
 
+	/**
+	 * @brief retrieve the pool of the given component type, constructing it if it does not exist
+	 */
+	template <typename Component>
+	component_pool& assure() {
+		size_t cid = component_id<Component>();
+		if (cid >= m_components.size()) {
+			m_components.resize(cid + 1);
+		}
+		if (!m_components[cid]) {
+			m_components[cid].reset(new component_pool(MAX_COMPONENTS, sizeof(Component), soa_fields_of<Component>(), lifecycle::of<Component>(),
+														 m_resource, alignof(Component)));
+			m_component_ids.emplace(std::type_index(typeid(Component)), cid);
+		}
+		return *m_components[cid];
+	}
+
+	/**
+	 * @brief check that every entity of the range can be given the component,
+	 * and make room for them all in its pool
+	 *
+	 * @return the pool of the component
+	 */
+	template <typename Component, typename EntityIt>
+	component_pool& prepare_insert(EntityIt first, EntityIt last) {
+		component_pool& pool = assure<Component>();
+		std::vector<entity_id> ids;
+		ids.reserve(std::distance(first, last));
+		for (EntityIt it = first; it != last; ++it) {
+			const auto& e = *it;
+			if (!owns(e)) {
+				throw std::runtime_error("Entity is not in the registry.");
+			}
+			if (pool.contains(e.id())) {
+				throw std::runtime_error("Component already exists.");
+			}
+			ids.push_back(e.id());
+		}
+		// an entity listed twice would get the component twice
+		std::sort(ids.begin(), ids.end());
+		if (std::adjacent_find(ids.begin(), ids.end()) != ids.end()) {
+			throw std::runtime_error("Component already exists.");
+		}
+		pool.reserve(pool.count() + ids.size());
+		return pool;
+	}
+
+	/**
+	 * @return true if the handle points to an entity of this registry
+	 */
+	bool owns(const entity_t& e) const;
+
 	/**
 	 * @brief add a component to the pool
 	 *
+	 * @param id the id of the entity to add the component to
 	 * @param args the arguments to construct the component with
 	 *
-	 * @returns the index of that component to save
+	 * @returns the newly added component, a soa_ref if stored as a structure of arrays
 	 */
 	template <typename Component, typename... Args>
-	size_t add(Args&&... args) {
-		std::type_index ti(typeid(Component));
-		// construct the component pool of this type if it does not exist
-		if (!m_components.contains(ti)) {
-			m_components.try_emplace(
-				ti,
-				MAX_COMPONENTS,
-				(size_t)sizeof(Component));
-		}
-		if (!m_components.contains(ti)) throw std::logic_error(";-;");
-		// retrieve the pool
-		component_pool& pool = m_components.at(ti);
+	component_ref_t<Component> add(entity_id id, Args&&... args) {
+		// retrieve the pool, constructing it if it does not exist
+		component_pool& pool = assure<Component>();
 		// add the component
-		return pool.add<Component, Args...>(args...);
+		pool.add<Component>(id, std::forward<Args>(args)...);
+		// joining a group may move it
+		added(component_id<Component>(), id);
+		return component_ref<Component>(&pool, pool.index(id));
 	}
 
 	/**
 	 * @brief remove a component from the pool
 	 *
 	 * @tparam Component the type of component to remove
-	 * @param idx the index of the component to remove
+	 * @param id the id of the entity owning the component
 	 */
 	template <typename Component>
-	void remove(size_t idx) {
-		std::type_index ti(typeid(Component));
-		remove(ti, idx);
+	void remove(entity_id id) {
+		if (component_pool* p = find_pool<Component>()) {
+			removing(component_id<Component>(), id);
+			p->remove(id);
+		}
 	}
 
 	/**
-	 * @brief remove a component from the pool
+	 * @brief sort the pool of the given component_id by entity index unless a group owns it, then shrink it
+	 *
+	 * @return how many bytes were released
+	 */
+	size_t compact_pool(size_t cid);
+
+	/**
+	 * @return true if a group owns the pool of the given component_id
+	 */
+	bool grouped(size_t cid) const;
+
+	/**
+	 * @brief the entities of a pool, sorted by index
+	 */
+	static std::vector<entity_id> sorted_entities(const component_pool& pool);
+
+	/**
+	 * @brief retrieve the owning group of exactly the given pools, creating it if it does not exist
+	 *
+	 * @param owned the component_id of each pool
+	 * @param pools the pools, parallel to owned
+	 *
+	 * @remarks throws if one of the pools is already owned by a different group
+	 */
+	group_storage& assure_group(std::vector<size_t> owned, std::vector<component_pool*> pools);
+
+	/**
+	 * @brief retrieve the cached query of exactly the given components, creating it if it does not exist
+	 *
+	 * @tparam Required a type_list of the components each entity must have
+	 * @tparam Excluded a type_list of the components no entity may have
+	 */
+	template <typename Required, typename Excluded>
+	query_storage& assure_query() {
+		return [this]<typename... R, typename... E>(type_list<R...>, type_list<E...>) -> query_storage& {
+			static_assert(sizeof...(R) > 0, "a query must require at least one component");
+			return assure_query(component_mask::of<R...>(), component_mask::of<E...>(), { find_pool<R>()... });
+		}(Required{}, Excluded{});
+	}
+
+	/**
+	 * @brief retrieve the cached query of exactly the given masks, creating it if it does not exist
+	 *
+	 * @param required the components each entity must have
+	 * @param excluded the components no entity may have
+	 * @param pools the pool of each required component, nullptr for the types no component was ever added of
+	 */
+	query_storage& assure_query(component_mask required, component_mask excluded, std::vector<const component_pool*> pools);
+
+	/**
+	 * @brief keep the groups and queries up to date after a component was added to an entity, then signal it
+	 *
+	 * @param cid the component_id of the component added
+	 * @param id the id of the entity
+	 */
+	void added(size_t cid, entity_id id);
+
+	/**
+	 * @brief signal that a component is about to be removed from an entity, then keep the groups and queries up to date
+	 *
+	 * @param cid the component_id of the component being removed
+	 * @param id the id of the entity
+	 */
+	void removing(size_t cid, entity_id id);
+
+	/**
+	 * @brief signal that an entity's component was modified with entity::patch()
+	 *
+	 * @param cid the component_id of the component modified
+	 * @param id the id of the entity
+	 */
+	void updated(size_t cid, entity_id id);
+
+	/**
+	 * @brief retrieves the specified component of an entity
+	 *
+	 * @tparam Component the component to retrieve
+	 * @param id the id of the entity owning the component
+	 *
+	 * @remarks throws if the component does not exist
+	 */
+	template <typename Component>
+	Component& get(entity_id id) {
+		static_assert(!is_soa_v<Component>, "components stored as a structure of arrays have no address");
+		component_pool* p = find_pool<Component>();
+		if (!p) {
+			throw std::out_of_range("Type not in component pool.");
+		}
+		return *p->get<Component>(id);
+	}
+
+	/**
+	 * @brief retrieves the specified component of an entity
+	 *
+	 * @tparam Component the component to retrieve
+	 * @param id the id of the entity owning the component
+	 *
+	 * @remarks throws if the component does not exist
+	 */
+	template <typename Component>
+	const Component& get(entity_id id) const {
+		static_assert(!is_soa_v<Component>, "components stored as a structure of arrays have no address");
+		const component_pool* p = find_pool<Component>();
+		if (!p) {
+			throw std::out_of_range("Type not in component pool.");
+		}
+		return *p->get<Component>(id);
+	}
+
+	/**
+	 * @brief retrieves the specified component of an entity
 	 *
-	 * @param ti the type of component to remove
-	 * @param idx the index of the component to remove
+	 * @tparam Component the component to retrieve
+	 * @param id the id of the entity owning the component
+	 * @return nullptr if the component does not exist
 	 */
-	void remove(std::type_index ti, size_t idx);
+	template <typename Component>
+	Component* try_get(entity_id id) {
+		static_assert(!is_soa_v<Component>, "components stored as a structure of arrays have no address");
+		component_pool* p = find_pool<Component>();
+		return p ? p->try_get<Component>(id) : nullptr;
+	}
 
 	/**
-	 * @brief retrieves the specified component at index idx
+	 * @brief retrieves the specified component of an entity
 	 *
 	 * @tparam Component the component to retrieve
-	 * @param idx the index of the component
+	 * @param id the id of the entity owning the component
+	 * @return nullptr if the component does not exist
+	 */
+	template <typename Component>
+	const Component* try_get(entity_id id) const {
+		static_assert(!is_soa_v<Component>, "components stored as a structure of arrays have no address");
+		const component_pool* p = find_pool<Component>();
+		return p ? p->try_get<Component>(id) : nullptr;
+	}
+
+	/**
+	 * @brief returns true if the entity has a component of the given type
 	 *
-	 * @remarks throws if the index does not exist
+	 * @tparam Component the type of the component
+	 * @param id the id of the entity
 	 */
 	template <typename Component>
-	Component& get(size_t idx) {
-		std::type_index ti(typeid(Component));
-		return *m_components.at(ti).get<Component>(idx);
+	bool has(entity_id id) const {
+		const component_pool* p = find_pool<Component>();
+		return p && p->contains(id);
 	}
 
+	/**
+	 * @brief returns true if the entity has a component of the given type
+	 *
+	 * @param ti the type of the component
+	 * @param id the id of the entity
+	 */
+	bool has(std::type_index ti, entity_id id) const;
+
 	/**
 	 * @brief member to produce a function that checks an entity's components,
 	 * as a workaround for circular dependencies
@@ -182,12 +817,58 @@ private:
 		return fst;
 	}
 
-	/// vector of entities in the registry
-	std::list<entity_t> m_entities;
+	/// where pools and entity records are allocated from
+	std::pmr::memory_resource* m_resource;
+	/// ids of the entities in the registry
+	sparse_set m_entities;
+	/// ids to reuse for new entities: the indices of removed entities, with their generation bumped
+	std::pmr::vector<entity_id> m_free_ids;
+	/// the position in m_free_ids of the id to reuse for each entity index, or sparse_set::npos if it isn't free
+	std::pmr::vector<size_t> m_free_slots;
+	/// the next never-used entity index
+	size_t m_next_index;
+	/// the current tick, read by tracked pools to stamp their components
+	uint64_t m_tick;
+	/// the component types of each entity, kept in step with the pools by added() and removing()
+	signature_set m_signatures;
+
+	/// the thread pool for parallel iteration, started lazily
+	mutable std::shared_ptr<thread_pool> m_workers;
+	/// guards m_workers
+	mutable std::mutex m_workers_mtx;
+
+	/// the owning groups, each owning a disjoint set of pools
+	std::vector<std::unique_ptr<group_storage>> m_groups;
+	/// the cached queries
+	std::vector<std::unique_ptr<query_storage>> m_queries;
+	/// the events of each component type, indexed by component_id.
+	/// nullptr for types nothing ever listened to, so they cost a lookup
+	std::vector<std::unique_ptr<component_signals>> m_signals;
+	/// the observers connected to the signals, disconnected when the registry is destroyed
+	std::vector<observer*> m_observers;
+
+	/// how far the incremental compaction got
+	struct compaction {
+		/// the component_id of the pool being sorted
+		size_t cid = 0;
+		/// the position of the pool's packed arrays to resume from
+		size_t pos = 0;
+		/// the entities of the pool, sorted by index. empty until the pool is started
+		std::vector<entity_id> order;
+	} m_compaction;
+
+	/// the types registered for snapshots, by component_id
+	std::unordered_map<size_t, snapshot_type> m_snapshot_types;
+	/// the snapshots pools use pages of, unmapped after the pools are destroyed
+	std::vector<std::unique_ptr<mapped_file>> m_mappings;
+
+	/// map of component types to their component_id, for runtime lookups
+	std::unordered_map<std::type_index, size_t> m_component_ids;
 
-	/// map of component types to their storage pool
+	/// storage pool of each component type, indexed by component_id
+	/// (nullptr for types never added to this registry)
 public:
-	std::unordered_map<std::type_index, component_pool> m_components;
+	std::vector<std::unique_ptr<component_pool>> m_components;
 };
 
 }
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <internal/component_id.hpp>
+#include <internal/system_traits.hpp>
+
+#include <entity.hpp>
+#include <registry.hpp>
+#include <view.hpp>
+
+namespace ecs {
+
+/**
+ * @brief runs a set of systems over a registry, running systems that touch
+ * disjoint components at the same time on the registry's thread pool
+ *
+ * systems declare their access in their type, e.g.
+ * add<reads<velocity>, writes<position>>([](position& p, const velocity& v) { ... }).
+ * two systems conflict if one writes a component the other reads or writes,
+ * and conflicting systems always run in the order they were added
+ */
+class scheduler {
+public:
+	/**
+	 * @brief constructor
+	 *
+	 * @param r the registry to run the systems over
+	 */
+	scheduler(registry& r);
+
+	/**
+	 * @brief add a system, run on each entity having all the components it takes
+	 *
+	 * @tparam Access any amount of reads<...> and writes<...>
+	 * @param system a callable taking each component by reference, mutable ones only if declared in writes<>.
+	 * components stored as a structure of arrays are taken as soa_ref<Component>, or soa_ref<const Component> to read them
+	 *
+	 * @remarks fails to compile if the system takes a component it did not declare,
+	 * or a mutable reference to a component it only declared in reads<>
+	 */
+	template <typename... Access, typename Fn>
+	scheduler& add(Fn&& system) {
+		using access = access_set<Access...>;
+		using params = typename callable_args<Fn>::type;
+		static_assert(std::tuple_size_v<params> > 0, "a system must take at least one component");
+		[]<typename... Params>(std::tuple<Params...>*) {
+			static_assert((true && ... && !std::is_same_v<typename param_access<Params>::component, entity_t>),
+						  "a system can't take an entity handle, as it would bypass the declared access");
+			static_assert((true && ... && allowed_param<Params, access>()),
+						  "a system takes a component it didn't declare, or mutates one it only reads");
+		}((params*)nullptr);
+
+		std::vector<size_t> read  = ids(typename access::read_t{});
+		std::vector<size_t> write = ids(typename access::write_t{});
+		insert(make_runner<typename access::write_t>(std::forward<Fn>(system), (params*)nullptr), std::move(read), std::move(write));
+		return *this;
+	}
+
+	/**
+	 * @brief run every system once, blocking until all are done
+	 *
+	 * @remarks the registry must not gain or lose entities or components while the systems run.
+	 * rethrows the first exception thrown by a system, after its stage finishes
+	 */
+	void run();
+
+	/**
+	 * @return how many systems were added
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief how many stages run() takes. every system of a stage runs at once,
+	 * after every system of the previous stage
+	 */
+	size_t stages() const;
+
+	/**
+	 * @return the stage the system added at the given index runs in
+	 */
+	size_t stage(size_t system) const;
+
+private:
+	/// a registered system
+	struct system {
+		/// runs the system over the registry
+		std::function<void(registry&)> run;
+		/// the component_id of every component read, sorted
+		std::vector<size_t> read;
+		/// the component_id of every component written, sorted
+		std::vector<size_t> write;
+		/// the stage it runs in
+		size_t stage;
+	};
+
+	/// the registry systems run over
+	registry& m_reg;
+	/// every system, in the order they were added
+	std::vector<system> m_systems;
+	/// the indices of the systems in each stage
+	std::vector<std::vector<size_t>> m_stages;
+
+	/**
+	 * @brief place a system in the stage after the last one it conflicts with
+	 */
+	void insert(std::function<void(registry&)> run, std::vector<size_t> read, std::vector<size_t> write);
+
+	/**
+	 * @return true if the two systems touch a component one of them writes
+	 */
+	static bool conflicts(const system& a, const system& b);
+
+	/// the sorted component ids of a declared access list
+	template <template <typename...> class List, typename... Components>
+	static std::vector<size_t> ids(List<Components...>) {
+		std::vector<size_t> out{ component_id<Components>()... };
+		std::sort(out.begin(), out.end());
+		return out;
+	}
+
+	/// wraps a system to run it over a view of the components it takes, stamping only those in Written as changed
+	template <typename Written, typename Fn, typename... Params>
+	static std::function<void(registry&)> make_runner(Fn&& system, std::tuple<Params...>*) {
+		return [system = std::forward<Fn>(system)](registry& r) mutable {
+			r.view<typename param_access<Params>::component...>().template each_writing<Written>(system);
+		};
+	}
+};
+
+}
@@ -1,98 +1,169 @@
 #pragma once
 
-#include <functional>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <memory>
-#include <range/v3/all.hpp>
+#include <span>
 #include <stdexcept>
 #include <type_traits>
 #include <typeindex>
+#include <utility>
+#include <vector>
 
 #include <internal/component_pool.hpp>
+#include <internal/component_ref.hpp>
 #include <internal/const_view_iterator.hpp>
+#include <internal/signature_set.hpp>
 #include <internal/view_iterator.hpp>
+#include <internal/view_terms.hpp>
 
 #include <entity.hpp>
 #include <registry.hpp>
-#include "range/v3/view/filter.hpp"
 
 namespace ecs {
 
 /**
- * @brief provides an interface for accessing requested entities / components
+ * @brief how view::par_each splits its work
+ */
+struct par_options {
+	/// how many entities of the driving pool each task walks.
+	/// views with no more entities than this run inline
+	size_t grain = 1024;
+};
+
+/**
+ * @brief keeps the entities of a view whose component in one of its pools was added or changed after a tick
  */
-template <typename... Components>
-class view {
+struct tick_filter {
+	/// the index of the pool in the view
+	size_t pool;
+	/// the tick the component must be stamped after
+	uint64_t since;
+	/// true to compare the tick the component was added in, rather than last changed in
+	bool added;
+};
+
+template <typename Required, typename Excluded, typename Optional>
+class basic_view;
+
+/**
+ * @brief what a view does, over its terms split into the components it requires, excludes and hands out if present.
+ * callbacks are given the required components, then a pointer to each optional one
+ */
+template <typename... Components, typename... Excluded, typename... Optional>
+class basic_view<type_list<Components...>, type_list<Excluded...>, type_list<Optional...>> {
+	static_assert(sizeof...(Components) > 0, "a view must require at least one component");
+	static_assert((true && ... && !is_soa_v<Optional>), "optional components are handed out by address, which components stored as a structure of arrays don't have");
+
 public:
+	/// iterates over the view
+	using iterator = view_iterator<type_list<Components...>, type_list<Excluded...>, type_list<Optional...>>;
+	/// iterates over a const view
+	using const_iterator = const_view_iterator<type_list<Components...>, type_list<Excluded...>, type_list<Optional...>>;
+
 	/**
-	 * @brief runs a callback on each set of components
+	 * @brief runs a callback on each entity having all the components
 	 *
-	 * @param callback
+	 * @param callback any callable taking either (entity_t, Components&..., Optional*...) or (Components&..., Optional*...).
+	 * components stored as a structure of arrays are passed as soa_ref<Component> instead
 	 */
-	void each(std::function<void(Components&...)> callback) {
-		// clang-format off
-		std::vector<entity_t> ents = reg().entities() 
-			| ranges::views::filter([](entity_t e) {
-				return e->has<Components...>();
-			})
-			| ranges::to<std::vector<entity_t>>();
-		// clang-format on
-		for (auto& ent : ents) {
-			callback(ent->get<Components>()...);
-		}
+	template <typename Fn>
+	void each(Fn&& callback) {
+		static_assert(std::is_invocable_v<Fn&, entity_t, component_ref_t<Components>..., Optional*...> ||
+						  std::is_invocable_v<Fn&, component_ref_t<Components>..., Optional*...>,
+					  "each() callback must take (entity_t, Components&..., Optional*...) or (Components&..., Optional*...)");
+		registry& r = reg();
+		for_each_match(r, m_filters, adapt(r, callback));
 	}
 
 	/**
-	 * @brief runs a callback on each set of components
+	 * @brief runs a callback on each entity having all the components
 	 *
-	 * @param callback
+	 * @param callback any callable taking either (entity_t, const Components&..., const Optional*...)
+	 * or (const Components&..., const Optional*...).
+	 * components stored as a structure of arrays are passed as soa_ref<const Component> instead
 	 */
-	void each(std::function<void(const Components&...)> callback) const {
-		// clang-format off
-		std::vector<entity_t> ents = reg().entities() 
-			| ranges::views::filter([](entity_t e) {
-				return e->has<Components...>();
-			})
-			| ranges::to<std::vector<entity_t>>();
-		// clang-format on
-		for (auto& ent : ents) {
-			callback(ent->get<Components>()...);
-		}
+	template <typename Fn>
+	void each(Fn&& callback) const {
+		static_assert(std::is_invocable_v<Fn&, entity_t, component_ref_t<const Components>..., const Optional*...> ||
+						  std::is_invocable_v<Fn&, component_ref_t<const Components>..., const Optional*...>,
+					  "each() callback must take (entity_t, const Components&..., const Optional*...) or (const Components&..., const Optional*...)");
+		const registry& r = reg();
+		for_each_match(r, m_filters, adapt(r, callback));
 	}
 
 	/**
-	 * @brief runs a callback on each entity and their set of components
+	 * @brief runs a callback on each entity having all the components,
+	 * split into chunks over the registry's thread pool
 	 *
-	 * @param callback
+	 * @param callback same as each(), but called concurrently:
+	 * it must only modify the components of the entity it is given
+	 * @param options how to split the work
 	 */
-	void each(std::function<void(entity_t, Components&...)> callback) {
-		// clang-format off
-		std::vector<entity_t> ents = reg().entities() 
-			| ranges::views::filter([](entity_t e) {
-				return e->has<Components...>();
-			})
-			| ranges::to<std::vector<entity_t>>();
-		// clang-format on
-		for (auto& ent : ents) {
-			callback(ent, ent->get<Components>()...);
-		}
+	template <typename Fn>
+	void par_each(Fn&& callback, par_options options = {}) {
+		static_assert(std::is_invocable_v<Fn&, entity_t, component_ref_t<Components>..., Optional*...> ||
+						  std::is_invocable_v<Fn&, component_ref_t<Components>..., Optional*...>,
+					  "par_each() callback must take (entity_t, Components&..., Optional*...) or (Components&..., Optional*...)");
+		registry& r = reg();
+		par_for_each_match(r, m_filters, options, adapt(r, callback));
 	}
 
 	/**
-	 * @brief runs a callback on each entity and their set of components
+	 * @brief runs a callback on each entity having all the components,
+	 * split into chunks over the registry's thread pool
 	 *
-	 * @param callback
+	 * @param callback same as each(), but called concurrently
+	 * @param options how to split the work
 	 */
-	void each(std::function<void(entity_t, const Components&...)> callback) const {
-		// clang-format off
-		std::vector<entity_t> ents = reg().entities() 
-			| ranges::views::filter([](entity_t e) {
-				return e->has<Components...>();
-			})
-			| ranges::to<std::vector<entity_t>>();
-		// clang-format on
-		for (auto& ent : ents) {
-			callback(ent, ent->get<Components>()...);
-		}
+	template <typename Fn>
+	void par_each(Fn&& callback, par_options options = {}) const {
+		static_assert(std::is_invocable_v<Fn&, entity_t, component_ref_t<const Components>..., const Optional*...> ||
+						  std::is_invocable_v<Fn&, component_ref_t<const Components>..., const Optional*...>,
+					  "par_each() callback must take (entity_t, const Components&..., const Optional*...) or (const Components&..., const Optional*...)");
+		const registry& r = reg();
+		par_for_each_match(r, m_filters, options, adapt(r, callback));
+	}
+
+	/**
+	 * @brief runs a callback on each contiguous run of entities having all the components,
+	 * for loops the compiler can vectorize.
+	 * runs never cross a page of a pool, and the component arrays start on their page's index,
+	 * so a run starting at the beginning of a page is aligned to component_pool::PAGE_ALIGN
+	 *
+	 * @param callback any callable taking either (std::span<const entity_id>, std::span<Components>...)
+	 * or (std::span<Components>...), all of the same length.
+	 * components stored as a structure of arrays are passed as soa_span<Component>, with a span per field
+	 *
+	 * @remarks not available to views with optional components, which can't be handed out as spans
+	 */
+	template <typename Fn>
+	void each_chunk(Fn&& callback) {
+		static_assert(sizeof...(Optional) == 0, "each_chunk() can't hand out optional components");
+		static_assert(std::is_invocable_v<Fn&, std::span<const entity_id>, component_span_t<Components>...> ||
+						  std::is_invocable_v<Fn&, component_span_t<Components>...>,
+					  "each_chunk() callback must take (std::span<const entity_id>, std::span<Components>...) or (std::span<Components>...)");
+		for_each_run(reg(), m_filters, adapt_chunk(callback));
+	}
+
+	/**
+	 * @brief runs a callback on each contiguous run of entities having all the components,
+	 * for loops the compiler can vectorize
+	 *
+	 * @param callback any callable taking either (std::span<const entity_id>, std::span<const Components>...)
+	 * or (std::span<const Components>...), all of the same length.
+	 * components stored as a structure of arrays are passed as soa_span<const Component>, with a span per field
+	 *
+	 * @remarks not available to views with optional components, which can't be handed out as spans
+	 */
+	template <typename Fn>
+	void each_chunk(Fn&& callback) const {
+		static_assert(sizeof...(Optional) == 0, "each_chunk() can't hand out optional components");
+		static_assert(std::is_invocable_v<Fn&, std::span<const entity_id>, component_span_t<const Components>...> ||
+						  std::is_invocable_v<Fn&, component_span_t<const Components>...>,
+					  "each_chunk() callback must take (std::span<const entity_id>, std::span<const Components>...) or (std::span<const Components>...)");
+		for_each_run(reg(), m_filters, adapt_chunk(callback));
 	}
 
 	/**
@@ -100,8 +171,8 @@ public:
 	 *
 	 * @remarks becomes invalid if the registry is modified during iteration
 	 */
-	view_iterator<Components...> begin() {
-		return view_iterator<Components...>(reg(), 0);
+	iterator begin() {
+		return iterator(unfiltered(reg()), false);
 	}
 
 	/**
@@ -109,8 +180,8 @@ public:
 	 *
 	 * @remarks becomes invalid if the registry is modified during iteration
 	 */
-	view_iterator<Components...> end() {
-		return view_iterator<Components...>(reg(), reg().count());
+	iterator end() {
+		return iterator(unfiltered(reg()), true);
 	}
 
 	/**
@@ -118,8 +189,8 @@ public:
 	 *
 	 * @remarks becomes invalid if the registry is modified during iteration
 	 */
-	const_view_iterator<Components...> begin() const {
-		return const_view_iterator<Components...>(reg(), 0);
+	const_iterator begin() const {
+		return const_iterator(unfiltered(reg()), false);
 	}
 
 	/**
@@ -127,28 +198,51 @@ public:
 	 *
 	 * @remarks becomes invalid if the registry is modified during iteration
 	 */
-	const_view_iterator<Components...> end() const {
-		return const_view_iterator<Components...>(reg(), reg().count());
+	const_iterator end() const {
+		return const_iterator(unfiltered(reg()), true);
 	}
 
-private:
-	friend class registry;
-	friend class view_iterator<Components...>;
-
+protected:
 	/**
 	 * @brief can only be instantiated by the registry api
 	 */
-	view(registry* r)
+	basic_view(registry* r)
 		: m_reg(r),
-		  m_reg_const(nullptr) {
+		  m_reg_const(nullptr),
+		  m_filters() {
 	}
 
 	/**
 	 * @brief can only be instantiated by the registry api
 	 */
-	view(const registry* r)
+	basic_view(const registry* r)
 		: m_reg(nullptr),
-		  m_reg_const(r) {
+		  m_reg_const(r),
+		  m_filters() {
+	}
+
+	/**
+	 * @brief keep only the entities whose component was changed (or added) after a tick
+	 */
+	template <typename Component>
+	void add_filter(uint64_t since, bool added) {
+		m_filters.push_back(tick_filter{ index_of<Component>(), since, added });
+	}
+
+private:
+	friend class scheduler;
+
+	/**
+	 * @brief each(), only stamping the components listed in Written as changed.
+	 * the scheduler runs systems with what they declared: the components they only read are not written to,
+	 * so systems reading the same tracked pool can run at once
+	 *
+	 * @tparam Written a list of the components the callback modifies, e.g. writes<...>
+	 */
+	template <typename Written, typename Fn>
+	void each_writing(Fn&& callback) {
+		registry& r = reg();
+		for_each_match<Written>(r, m_filters, adapt(r, callback));
 	}
 
 	const registry& reg() const {
@@ -165,10 +259,426 @@ private:
 			throw std::runtime_error("No non-constant registry object in non-constant registry view.");
 	}
 
+	/**
+	 * @brief pass the registry through, throwing if the view is filtered
+	 */
+	template <typename Registry>
+	Registry& unfiltered(Registry& r) const {
+		if (!m_filters.empty()) {
+			throw std::runtime_error("Walk a filtered view with each(), par_each() or each_chunk().");
+		}
+		return r;
+	}
+
+	/**
+	 * @brief the index of a required component in the view
+	 */
+	template <typename Component>
+	static constexpr size_t index_of() {
+		constexpr std::array<bool, sizeof...(Components)> same{ std::is_same_v<Component, Components>... };
+		static_assert(std::find(same.begin(), same.end(), true) != same.end(), "not a required component of the view");
+		return std::find(same.begin(), same.end(), true) - same.begin();
+	}
+
+	/**
+	 * @brief the pools of the excluded and optional components, nullptr for the types no component was ever added of,
+	 * and the masks of the required and excluded types to test entity signatures against
+	 */
+	template <typename Pool>
+	struct other_pools {
+		/// the pool of each excluded component
+		std::array<Pool*, sizeof...(Excluded)> excluded;
+		/// the pool of each optional component
+		std::array<Pool*, sizeof...(Optional)> optional;
+		/// the signatures of the registry's entities
+		const signature_set* signatures;
+		/// the required component types
+		component_mask required;
+		/// the excluded component types
+		component_mask excludes_mask;
+
+		/// true if the entity, taken from a required pool, has every other required component and no excluded one
+		bool admits(entity_id id) const {
+			if constexpr (sizeof...(Components) == 1 && sizeof...(Excluded) == 0) {
+				return true;
+			} else {
+				return signatures->matches(entity_index(id), required, excludes_mask);
+			}
+		}
+
+		/// true if no entity has an excluded component
+		bool excludes_none() const {
+			return std::all_of(excluded.begin(), excluded.end(), [](Pool* p) {
+				return !p || p->count() == 0;
+			});
+		}
+	};
+
+	/**
+	 * @return false if the filters on the D-th pool rule out every component of its i-th page
+	 */
+	template <typename Pool>
+	static bool page_passes(const Pool& pool, const std::vector<tick_filter>& filters, size_t D, size_t page) {
+		for (const tick_filter& f : filters) {
+			if (f.pool == D && (f.added ? pool.page_added_at(page) : pool.page_changed_at(page)) <= f.since) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @return the pool a filter is on.
+	 * a single component view has only one, which is returned as is so no index past the array is ever formed
+	 */
+	template <typename Pool>
+	static Pool* filtered_pool(const std::array<Pool*, sizeof...(Components)>& pools, const tick_filter& f) {
+		if constexpr (sizeof...(Components) == 1) {
+			return pools[0];
+		} else {
+			return pools[f.pool];
+		}
+	}
+
+	/**
+	 * @return true if the components of an entity pass every filter
+	 *
+	 * @param i the index of the entity in the packed arrays of the D-th pool
+	 * @remarks the entity must be in every pool
+	 */
+	template <typename Pool>
+	static bool passes(const std::array<Pool*, sizeof...(Components)>& pools, const std::vector<tick_filter>& filters,
+					   size_t D, size_t i, entity_id id) {
+		for (const tick_filter& f : filters) {
+			Pool* pool = filtered_pool(pools, f);
+			size_t idx = f.pool == D ? i : pool->index(id);
+			if ((f.added ? pool->added_at(idx) : pool->changed_at(idx)) <= f.since) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief adapts a callback taking (entity_t, Components&..., Optional*...) or (Components&..., Optional*...)
+	 * to the (entity_id, Components&..., Optional*...) form used by for_each_match
+	 */
+	template <typename Registry, typename Fn>
+	static auto adapt(Registry& r, Fn& callback) {
+		return [&r, &callback](entity_id id, auto&&... components) {
+			if constexpr (std::is_invocable_v<Fn&, entity_t, decltype((components))...>) {
+				callback(r.handle(id), components...);
+			} else {
+				callback(components...);
+			}
+		};
+	}
+
+	/**
+	 * @brief calls fn with the id and components of every entity having all of the required components and none of the excluded ones.
+	 * walks the packed arrays of the pool with the fewest components, checking the other pools for membership
+	 *
+	 * @param r the registry to search
+	 * @param filters the tick filters the entities must pass
+	 * @param fn callback taking (entity_id id, Components&..., Optional*...)
+	 * @tparam Stamped the components to stamp as changed as they are handed out, every required one by default
+	 */
+	template <typename Stamped = type_list<Components...>, typename Registry, typename Fn>
+	static void for_each_match(Registry& r, const std::vector<tick_filter>& filters, Fn&& fn) {
+		with_pools(r, filters, [&filters, &fn](auto& pools, auto& others, auto driver, auto stamp) {
+			constexpr size_t D = decltype(driver)::value;
+			for_each_driven<D, decltype(stamp)::value, Stamped>(pools, others, filters, 0, pools[D]->count(), fn);
+		});
+	}
+
+	/**
+	 * @brief adapts a chunk callback taking the entity ids or not
+	 * to the (std::span<const entity_id>, std::span<Components>...) form used by for_each_run
+	 */
+	template <typename Fn>
+	static auto adapt_chunk(Fn& callback) {
+		return [&callback](std::span<const entity_id> ids, auto... components) {
+			if constexpr (std::is_invocable_v<Fn&, std::span<const entity_id>, decltype(components)...>) {
+				callback(ids, components...);
+			} else {
+				callback(components...);
+			}
+		};
+	}
+
+	/**
+	 * @brief calls fn with spans over each run of entities having all of the required components and none of the excluded ones,
+	 * whose components sit at consecutive indices of every pool, within a single page of each
+	 *
+	 * @param r the registry to search
+	 * @param filters the tick filters the entities must pass
+	 * @param fn callback taking (std::span<const entity_id>, std::span<Components>...)
+	 */
+	template <typename Registry, typename Fn>
+	static void for_each_run(Registry& r, const std::vector<tick_filter>& filters, Fn&& fn) {
+		with_pools(r, filters, [&filters, &fn](auto& pools, auto& others, auto driver, auto stamp) {
+			constexpr size_t D	   = decltype(driver)::value;
+			constexpr size_t N	   = sizeof...(Components);
+			constexpr bool Stamp = decltype(stamp)::value;
+			const std::pmr::vector<entity_id>& ents = pools[D]->entities();
+			if constexpr (N == 1) {
+				// nothing to filter by, every page is a run
+				if (filters.empty() && others.excludes_none()) {
+					for (size_t begin = 0; begin < ents.size(); begin += component_pool::PAGE_SZ) {
+						size_t len = std::min(ents.size() - begin, component_pool::PAGE_SZ);
+						fn(std::span<const entity_id>(ents.data() + begin, len),
+						   component_span<Components, Stamp>(pools[0], begin, len)...);
+					}
+					return;
+				}
+			}
+			std::array<size_t, N> start{};
+			size_t len = 0;
+			auto flush = [&]() {
+				if (len == 0) return;
+				[&]<size_t... I>(std::index_sequence<I...>) {
+					fn(std::span<const entity_id>(ents.data() + start[D], len),
+					   component_span<Components, Stamp>(pools[I], start[I], len)...);
+				}
+				(std::index_sequence_for<Components...>{});
+				len = 0;
+			};
+			// read once, so unfiltered walks don't reload the filters for every entity
+			const bool filtered = !filters.empty();
+			for (size_t i = 0; i < ents.size(); ++i) {
+				if (filtered && i % component_pool::PAGE_SZ == 0 && !page_passes(*pools[D], filters, D, i / component_pool::PAGE_SZ)) {
+					flush();
+					i += component_pool::PAGE_SZ - 1;
+					continue;
+				}
+				if (!others.admits(ents[i]) || (filtered && !passes(pools, filters, D, i, ents[i]))) {
+					flush();
+					continue;
+				}
+				std::array<size_t, N> idx;
+				for (size_t k = 0; k < N; ++k) {
+					idx[k] = k == D ? i : pools[k]->index(ents[i]);
+				}
+				// extend the run if every pool continues it on the same page
+				bool extends = len > 0;
+				for (size_t k = 0; k < N && extends; ++k) {
+					extends = idx[k] == start[k] + len && idx[k] % component_pool::PAGE_SZ != 0;
+				}
+				if (!extends) {
+					flush();
+					start = idx;
+				}
+				len++;
+			}
+			flush();
+		});
+	}
+
+	/**
+	 * @brief for_each_match, with the packed arrays of the driving pool split into chunks run on the registry's thread pool.
+	 * runs inline if there is only one chunk
+	 */
+	template <typename Registry, typename Fn>
+	static void par_for_each_match(Registry& r, const std::vector<tick_filter>& filters, par_options options, Fn&& fn) {
+		with_pools(r, filters, [&r, &filters, &options, &fn](auto& pools, auto& others, auto driver, auto stamp) {
+			constexpr size_t D = decltype(driver)::value;
+			size_t n	  = pools[D]->count();
+			size_t grain  = std::max<size_t>(options.grain, 1);
+			size_t chunks = (n + grain - 1) / grain;
+			if (chunks <= 1) {
+				for_each_driven<D, decltype(stamp)::value>(pools, others, filters, 0, n, fn);
+				return;
+			}
+			r.workers().run(chunks, [&pools, &others, &filters, &fn, n, grain](size_t chunk) {
+				for_each_driven<D, decltype(stamp)::value>(pools, others, filters, chunk * grain, std::min(n, (chunk + 1) * grain), fn);
+			});
+		});
+	}
+
+	/**
+	 * @brief looks up the pools of every component and calls run(pools, others, driver, stamp),
+	 * others being the other_pools of the excluded and optional components,
+	 * driver being a std::integral_constant of the index of the pool with the fewest components,
+	 * or of the first filtered pool if there are filters, so pages they rule out can be skipped, and
+	 * stamp a std::bool_constant of whether handing out the required components must stamp them as changed.
+	 * does nothing if a pool does not exist
+	 *
+	 * @remarks throws if a filtered pool is not tracked
+	 */
+	template <typename Registry, typename Run>
+	static void with_pools(Registry& r, const std::vector<tick_filter>& filters, Run&& run) {
+		using pool_t = std::conditional_t<std::is_const_v<Registry>, const component_pool, component_pool>;
+		std::array<pool_t*, sizeof...(Components)> pools{ r.template find_pool<Components>()... };
+		if (std::find(pools.begin(), pools.end(), nullptr) != pools.end()) return;
+		other_pools<pool_t> others{ { r.template find_pool<Excluded>()... },
+									{ r.template find_pool<Optional>()... },
+									&r.signatures(),
+									component_mask::of<Components...>(),
+									component_mask::of<Excluded...>() };
+		for (const tick_filter& f : filters) {
+			if (!filtered_pool(pools, f)->tracked()) {
+				throw std::runtime_error("Component type of a filtered view is not tracked.");
+			}
+		}
+		size_t driver = filters.empty() ? smallest(pools) : filters.front().pool;
+		bool stamps	  = !std::is_const_v<Registry> && std::any_of(pools.begin(), pools.end(), [](pool_t* p) {
+			  return p->tracked();
+		  });
+		// dispatch to the loop specialized for that driving pool, checking whether to stamp once rather than per component
+		auto dispatch = [&](auto stamp) {
+			[&]<size_t... D>(std::index_sequence<D...>) {
+				((driver == D && (run(pools, others, std::integral_constant<size_t, D>{}, stamp), true)) || ...);
+			}
+			(std::index_sequence_for<Components...>{});
+		};
+		if (stamps) {
+			dispatch(std::true_type{});
+		} else {
+			dispatch(std::false_type{});
+		}
+	}
+
+	/**
+	 * @brief the index of the pool with the fewest components
+	 */
+	template <typename Pool, size_t N>
+	static size_t smallest(const std::array<Pool*, N>& pools) {
+		auto it = std::min_element(pools.begin(), pools.end(), [](Pool* a, Pool* b) {
+			return a->count() < b->count();
+		});
+		return it - pools.begin();
+	}
+
+	/**
+	 * @brief for_each_match over the packed indices [begin, end) of the D-th pool
+	 *
+	 * @tparam Stamp whether handing out the required components stamps them as changed
+	 * @tparam Stamped the components to stamp, if Stamp
+	 */
+	template <size_t D, bool Stamp, typename Stamped = type_list<Components...>, typename Pool, typename Fn>
+	static void for_each_driven(const std::array<Pool*, sizeof...(Components)>& pools, const other_pools<Pool>& others,
+								const std::vector<tick_filter>& filters, size_t begin, size_t end, Fn& fn) {
+		const std::pmr::vector<entity_id>& ents = pools[D]->entities();
+		for (size_t i = begin; i < end; ++i) {
+			// skip what is left of a page the filters rule out
+			if (!filters.empty() && (i == begin || i % component_pool::PAGE_SZ == 0) &&
+				!page_passes(*pools[D], filters, D, i / component_pool::PAGE_SZ)) {
+				i = std::min(end, (i / component_pool::PAGE_SZ + 1) * component_pool::PAGE_SZ) - 1;
+				continue;
+			}
+			entity_id id = ents[i];
+			[&]<size_t... I, size_t... J>(std::index_sequence<I...>, std::index_sequence<J...>) {
+				// the entity must have every other required component, and no excluded one, before fetching anything
+				if (others.admits(id) && passes(pools, filters, D, i, id)) {
+					fn(id, fetch<Components, I, D, Stamp && in_list_v<Components, Stamped>>(pools[I], i, id)..., component_ptr<Optional>(others.optional[J], id)...);
+				}
+			}
+			(std::index_sequence_for<Components...>{}, std::index_sequence_for<Optional...>{});
+		}
+	}
+
+	/**
+	 * @brief retrieve the component of the I-th pool of the view,
+	 * reading the driving D-th pool directly at its packed index
+	 */
+	template <typename Component, size_t I, size_t D, bool Stamp, typename Pool>
+	static component_ref_t<pool_component_t<Component, Pool>> fetch(Pool* pool, size_t i, entity_id id) {
+		return component_ref<Component, Stamp>(pool, I == D ? i : pool->index(id));
+	}
+
 	/// the registry this view originates from
 	registry* m_reg;
 	// const version
 	const registry* m_reg_const;
+	/// the tick filters the entities must pass
+	std::vector<tick_filter> m_filters;
+};
+
+/**
+ * @brief provides an interface for accessing requested entities / components
+ *
+ * @tparam Terms the components each entity must have, and exclude<...> or optional<...> terms:
+ * entities having an excluded component are skipped,
+ * and optional components are handed out after the required ones as pointers, nullptr if the entity has none
+ */
+template <typename... Terms>
+class view : public basic_view<typename view_terms<Terms...>::required, typename view_terms<Terms...>::excluded,
+							   typename view_terms<Terms...>::optional> {
+	/// what the view does
+	using base = basic_view<typename view_terms<Terms...>::required, typename view_terms<Terms...>::excluded,
+							typename view_terms<Terms...>::optional>;
+
+public:
+	/**
+	 * @brief a copy of this view keeping only the entities whose component was changed (or added) after a tick
+	 *
+	 * @tparam Component one of the required components of the view, tracked with registry::track()
+	 * @param since the tick, e.g. the one registry::advance_tick() returned when the system last ran
+	 *
+	 * @remarks pages of the pool with no component changed since are skipped without looking at them.
+	 * each(), par_each() and each_chunk() apply the filter, iterating a filtered view throws.
+	 * a non-const view stamps the components it hands out as changed, walk a const one to only read them
+	 */
+	template <typename Component>
+	view changed(uint64_t since) {
+		return filtered<Component>(since, false);
+	}
+
+	/**
+	 * @brief a copy of this view keeping only the entities whose component was changed (or added) after a tick
+	 *
+	 * @remarks see changed()
+	 */
+	template <typename Component>
+	const view changed(uint64_t since) const {
+		return filtered<Component>(since, false);
+	}
+
+	/**
+	 * @brief a copy of this view keeping only the entities whose component was added after a tick
+	 *
+	 * @tparam Component one of the required components of the view, tracked with registry::track()
+	 * @param since the tick, e.g. the one registry::advance_tick() returned when the system last ran
+	 *
+	 * @remarks see changed()
+	 */
+	template <typename Component>
+	view added(uint64_t since) {
+		return filtered<Component>(since, true);
+	}
+
+	/**
+	 * @brief a copy of this view keeping only the entities whose component was added after a tick
+	 *
+	 * @remarks see changed()
+	 */
+	template <typename Component>
+	const view added(uint64_t since) const {
+		return filtered<Component>(since, true);
+	}
+
+private:
+	friend class registry;
+
+	/**
+	 * @brief can only be instantiated by the registry api
+	 */
+	view(registry* r)
+		: base(r) {
+	}
+
+	/**
+	 * @brief can only be instantiated by the registry api
+	 */
+	view(const registry* r)
+		: base(r) {
+	}
+
+	/**
+	 * @brief a copy of this view with one more filter on the given component
+	 */
+	template <typename Component>
+	view filtered(uint64_t since, bool added) const {
+		view v = *this;
+		v.template add_filter<Component>(since, added);
+		return v;
+	}
 };
 
 }
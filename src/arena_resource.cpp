@@ -0,0 +1,96 @@
+#include "arena_resource.hpp"
+
+#include <algorithm>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace ecs {
+
+arena_resource::arena_resource(size_t chunk_sz, bool huge_pages)
+	: CHUNK_SZ((std::max<size_t>(chunk_sz, 1) + HUGE_PAGE_SZ - 1) / HUGE_PAGE_SZ * HUGE_PAGE_SZ),
+	  HUGE_PAGES(huge_pages),
+	  m_chunks(),
+	  m_chunk_used(0),
+	  m_current(nullptr),
+	  m_free(),
+	  m_allocated(0),
+	  m_reserved(0),
+	  m_mtx() {
+}
+
+arena_resource::~arena_resource() {
+}
+
+size_t arena_resource::allocated() const {
+	std::lock_guard<std::mutex> lk(m_mtx);
+	return m_allocated;
+}
+
+size_t arena_resource::reserved() const {
+	std::lock_guard<std::mutex> lk(m_mtx);
+	return m_reserved;
+}
+
+void* arena_resource::do_allocate(size_t bytes, size_t align) {
+	std::lock_guard<std::mutex> lk(m_mtx);
+	bytes = std::max<size_t>(bytes, 1);
+	// reuse a block freed with the same size and alignment
+	auto it = m_free.find({ bytes, align });
+	if (it != m_free.end() && !it->second.empty()) {
+		void* p = it->second.back();
+		it->second.pop_back();
+		m_allocated += bytes;
+		return p;
+	}
+	if (align > HUGE_PAGE_SZ) {
+		throw std::bad_alloc();
+	}
+	// blocks that don't fit in a chunk get their own
+	if (bytes > CHUNK_SZ / 2) {
+		char* p = new_chunk(bytes);
+		m_allocated += bytes;
+		return p;
+	}
+	size_t offset = (m_chunk_used + align - 1) / align * align;
+	if (!m_current || offset + bytes > CHUNK_SZ) {
+		m_current = new_chunk(CHUNK_SZ);
+		offset	  = 0;
+	}
+	m_chunk_used = offset + bytes;
+	m_allocated += bytes;
+	return m_current + offset;
+}
+
+void arena_resource::do_deallocate(void* p, size_t bytes, size_t align) {
+	std::lock_guard<std::mutex> lk(m_mtx);
+	bytes = std::max<size_t>(bytes, 1);
+	m_free[{ bytes, align }].push_back(p);
+	m_allocated -= bytes;
+}
+
+bool arena_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+char* arena_resource::new_chunk(size_t bytes) {
+	bytes	 = (bytes + HUGE_PAGE_SZ - 1) / HUGE_PAGE_SZ * HUGE_PAGE_SZ;
+	char* p = static_cast<char*>(::operator new[](bytes, std::align_val_t(HUGE_PAGE_SZ)));
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (HUGE_PAGES) {
+		// only a hint: the chunk works the same if the system declines
+		madvise(p, bytes, MADV_HUGEPAGE);
+	}
+#endif
+	m_chunks.emplace_back(p);
+	m_reserved += bytes;
+	return p;
+}
+
+void arena_resource::chunk_deleter::operator()(char* chunk) const {
+	::operator delete[](chunk, std::align_val_t(HUGE_PAGE_SZ));
+}
+
+}
@@ -0,0 +1,194 @@
+#include "command_buffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ecs {
+
+command_buffer::target::target(const entity_t& e)
+	: m_owner(nullptr),
+	  m_value(e.id()) {
+}
+
+command_buffer::target::target(placeholder p)
+	: m_owner(p.owner),
+	  m_value(p.index) {
+}
+
+command_buffer::command_buffer()
+	: m_commands(),
+	  m_creates(0),
+	  m_blocks(),
+	  m_block_used(0) {
+}
+
+command_buffer::~command_buffer() {
+	clear();
+}
+
+command_buffer::placeholder command_buffer::create() {
+	return placeholder{ this, m_creates++ };
+}
+
+void command_buffer::destroy(target e) {
+	check(e);
+	m_commands.push_back(command{ command::destroy, 0, e, nullptr, nullptr, nullptr, nullptr });
+}
+
+std::vector<entity_t> command_buffer::flush(registry& r) {
+	std::vector<entity_t> created;
+	created.reserve(m_creates);
+	// the placeholders are created first, in order, so their ids can be read back
+	for (size_t i = 0; i < m_creates; ++i) {
+		created.push_back(r.create());
+	}
+	m_creates = 0;
+	std::vector<std::vector<entity_id>> ids(1);
+	for (const entity_t& e : created) {
+		ids[0].push_back(e.id());
+	}
+	play(r, { this }, ids);
+	return created;
+}
+
+void command_buffer::flush(registry& r, const std::vector<command_buffer*>& buffers) {
+	std::vector<std::vector<entity_id>> ids(buffers.size());
+	for (size_t b = 0; b < buffers.size(); ++b) {
+		for (size_t i = 0; i < buffers[b]->m_creates; ++i) {
+			ids[b].push_back(r.create().id());
+		}
+		buffers[b]->m_creates = 0;
+	}
+	play(r, buffers, ids);
+}
+
+void command_buffer::clear() {
+	for (command& c : m_commands) {
+		if (c.dispose) c.dispose(c.payload);
+	}
+	m_commands.clear();
+	m_creates = 0;
+	// keep the first block around for the next commands
+	if (m_blocks.size() > 1) {
+		m_blocks.resize(1);
+	}
+	m_block_used = 0;
+}
+
+bool command_buffer::empty() const {
+	return m_commands.empty() && m_creates == 0;
+}
+
+void command_buffer::play(registry& r, const std::vector<command_buffer*>& buffers, const std::vector<std::vector<entity_id>>& created) {
+	/// a command along with the id of the entity it applies to
+	struct resolved {
+		command* c;
+		entity_id id;
+	};
+	std::vector<resolved> components;
+	std::vector<entity_id> destroyed;
+	try {
+		for (size_t b = 0; b < buffers.size(); ++b) {
+			for (command& c : buffers[b]->m_commands) {
+				entity_id id = c.e.m_owner ? created[b][c.e.m_value] : entity_id(c.e.m_value);
+				if (c.kind == command::destroy) {
+					destroyed.push_back(id);
+				} else {
+					components.push_back(resolved{ &c, id });
+				}
+			}
+		}
+		// one pool at a time, keeping the order of each component's commands
+		std::stable_sort(components.begin(), components.end(), [](const resolved& a, const resolved& b) {
+			return a.c->cid < b.c->cid;
+		});
+		for (size_t begin = 0; begin < components.size();) {
+			size_t end	= begin;
+			size_t adds = 0;
+			void (*reserve)(registry&, size_t) = nullptr;
+			while (end < components.size() && components[end].c->cid == components[begin].c->cid) {
+				if (components[end].c->kind == command::add) {
+					adds++;
+					reserve = components[end].c->reserve;
+				}
+				end++;
+			}
+			// grow the pool once for all its additions
+			if (reserve) reserve(r, adds);
+			for (size_t i = begin; i < end; ++i) {
+				components[i].c->apply(r, components[i].id, *components[i].c);
+			}
+			begin = end;
+		}
+		for (entity_id id : destroyed) {
+			if (r.valid(id)) r.remove(r.at(id));
+		}
+	} catch (...) {
+		for (command_buffer* b : buffers) {
+			b->clear();
+		}
+		throw;
+	}
+	for (command_buffer* b : buffers) {
+		b->clear();
+	}
+}
+
+void command_buffer::check(const target& e) const {
+	if (e.m_owner && e.m_owner != this) {
+		throw std::runtime_error("Placeholder entity belongs to another command buffer.");
+	}
+}
+
+void* command_buffer::allocate(size_t size, size_t align) {
+	size_t offset = (m_block_used + align - 1) / align * align;
+	if (m_blocks.empty() || offset + size > BLOCK_SZ) {
+		// payloads larger than a block get a block of their own
+		size_t bytes = std::max(size, BLOCK_SZ);
+		m_blocks.emplace_back(static_cast<char*>(::operator new[](bytes, std::align_val_t(BLOCK_ALIGN))));
+		offset = 0;
+	}
+	m_block_used = offset + size;
+	return m_blocks.back().get() + offset;
+}
+
+void command_buffer::block_deleter::operator()(char* block) const {
+	::operator delete[](block, std::align_val_t(BLOCK_ALIGN));
+}
+
+command_queue::command_queue(registry& r)
+	: m_reg(r),
+	  m_workers(r.workers()),
+	  m_worker_buffers(),
+	  m_other_buffers(),
+	  m_other_mtx() {
+	for (size_t i = 0; i < m_workers.size(); ++i) {
+		m_worker_buffers.emplace_back(new command_buffer());
+	}
+}
+
+command_buffer& command_queue::local() {
+	size_t worker = m_workers.current_worker();
+	if (worker < m_worker_buffers.size()) {
+		return *m_worker_buffers[worker];
+	}
+	std::lock_guard<std::mutex> lk(m_other_mtx);
+	auto& buffer = m_other_buffers[std::this_thread::get_id()];
+	if (!buffer) {
+		buffer.reset(new command_buffer());
+	}
+	return *buffer;
+}
+
+void command_queue::flush() {
+	std::vector<command_buffer*> buffers;
+	for (auto& b : m_worker_buffers) {
+		buffers.push_back(b.get());
+	}
+	for (auto& [id, b] : m_other_buffers) {
+		buffers.push_back(b.get());
+	}
+	command_buffer::flush(m_reg, buffers);
+}
+
+}
@@ -0,0 +1,426 @@
+#include "delta.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include <internal/byte_reader.hpp>
+
+#include <entity.hpp>
+
+namespace ecs {
+
+/// the first bytes of every delta
+static constexpr char DELTA_MAGIC[4] = { 'E', 'C', 'S', 'D' };
+/// bumped whenever the delta format changes
+static constexpr uint32_t DELTA_VERSION = 1;
+
+/// append a list of ids, prefixed by their count
+static void write_ids(std::vector<char>& out, const std::vector<entity_id>& ids) {
+	write_varint(out, ids.size());
+	for (entity_id id : ids) {
+		write_bytes(out, id);
+	}
+}
+
+/// read back a list of ids written by write_ids()
+static std::vector<entity_id> read_ids(byte_reader& in) {
+	size_t n = in.read_varint();
+	if (n > in.remaining() / sizeof(entity_id)) {
+		throw std::runtime_error("Data is truncated.");
+	}
+	std::vector<entity_id> ids(n);
+	for (entity_id& id : ids) {
+		id = in.read<entity_id>();
+	}
+	return ids;
+}
+
+/**
+ * @brief append the XOR of two components, run-length encoded:
+ * pairs of a run of unchanged bytes and a run of changed ones, the latter stored as is
+ */
+static void write_xor(std::vector<char>& out, const char* now, const char* before, size_t size) {
+	std::vector<char> runs;
+	size_t i = 0;
+	while (i < size) {
+		size_t zeros = 0;
+		for (; i < size && now[i] == before[i]; ++i) {
+			zeros++;
+		}
+		if (i == size) break;
+		size_t start = i;
+		for (; i < size && now[i] != before[i]; ++i) {}
+		write_varint(runs, zeros);
+		write_varint(runs, i - start);
+		for (size_t k = start; k < i; ++k) {
+			runs.push_back(now[k] ^ before[k]);
+		}
+	}
+	write_varint(out, runs.size());
+	out.insert(out.end(), runs.begin(), runs.end());
+}
+
+/**
+ * @brief check that the runs of write_xor() fit in a component of the given size
+ *
+ * @remarks throws if they don't
+ */
+static void check_xor(size_t size, const char* runs, size_t len) {
+	byte_reader in(runs, len);
+	size_t i = 0;
+	while (!in.done()) {
+		size_t zeros = in.read_varint();
+		if (zeros > size - i) {
+			throw std::runtime_error("Delta overflows a component.");
+		}
+		i += zeros;
+		size_t changed = in.read_varint();
+		in.bytes(changed);
+		if (changed > size - i) {
+			throw std::runtime_error("Delta overflows a component.");
+		}
+		i += changed;
+	}
+}
+
+/// XOR a component with runs written by write_xor()
+static void apply_xor(char* component, size_t size, const char* runs, size_t len) {
+	byte_reader in(runs, len);
+	size_t i = 0;
+	while (!in.done()) {
+		i += in.read_varint();
+		size_t changed	  = in.read_varint();
+		const char* bytes = in.bytes(changed);
+		if (i + changed > size) {
+			throw std::runtime_error("Delta overflows a component.");
+		}
+		for (size_t k = 0; k < changed; ++k) {
+			component[i + k] ^= bytes[k];
+		}
+		i += changed;
+	}
+}
+
+void delta_encoder::id_table::assign(const std::pmr::vector<entity_id>& from) {
+	for (entity_id id : ids) {
+		slot[entity_index(id)] = sparse_set::npos;
+	}
+	ids.assign(from.begin(), from.end());
+	for (size_t i = 0; i < ids.size(); ++i) {
+		size_t idx = entity_index(ids[i]);
+		if (idx >= slot.size()) {
+			slot.resize(idx + 1, sparse_set::npos);
+		}
+		slot[idx] = i;
+	}
+}
+
+size_t delta_encoder::id_table::find(entity_id id) const {
+	size_t idx = entity_index(id);
+	if (idx >= slot.size() || slot[idx] == sparse_set::npos) return sparse_set::npos;
+	return ids[slot[idx]] == id ? slot[idx] : sparse_set::npos;
+}
+
+delta_encoder::delta_encoder(const registry& r)
+	: m_reg(r),
+	  m_entities(),
+	  m_pools(),
+	  m_tick(0),
+	  m_scratch() {
+}
+
+std::vector<char> delta_encoder::encode() {
+	std::vector<char> out(DELTA_MAGIC, DELTA_MAGIC + sizeof(DELTA_MAGIC));
+	write_bytes(out, DELTA_VERSION);
+	write_bytes(out, m_tick);
+	write_bytes(out, m_tick + 1);
+
+	std::vector<entity_id> destroyed;
+	for (entity_id id : m_entities.ids) {
+		if (!m_reg.valid(id)) destroyed.push_back(id);
+	}
+	std::vector<entity_id> created;
+	for (entity_id id : m_reg.entities()) {
+		if (m_entities.find(id) == sparse_set::npos) created.push_back(id);
+	}
+	write_ids(out, destroyed);
+	write_ids(out, created);
+	m_entities.assign(m_reg.entities());
+
+	std::vector<char> pools;
+	size_t changed_pools = 0;
+	for (const auto& [cid, type] : m_reg.m_snapshot_types) {
+		if (!type.raw || cid >= m_reg.m_components.size() || !m_reg.m_components[cid]) continue;
+		auto base = std::find_if(m_pools.begin(), m_pools.end(), [cid = cid](const baseline_pool& p) {
+			return p.cid == cid;
+		});
+		if (base == m_pools.end()) {
+			m_pools.push_back(baseline_pool{ cid, {}, {} });
+			base = m_pools.end() - 1;
+		}
+		std::vector<char> pool;
+		write_varint(pool, type.name.size());
+		pool.insert(pool.end(), type.name.begin(), type.name.end());
+		// leave out pools that didn't change
+		if (encode_pool(pool, *base)) {
+			pools.insert(pools.end(), pool.begin(), pool.end());
+			changed_pools++;
+		}
+	}
+	write_varint(out, changed_pools);
+	out.insert(out.end(), pools.begin(), pools.end());
+	m_tick++;
+	return out;
+}
+
+bool delta_encoder::encode_pool(std::vector<char>& out, baseline_pool& base) {
+	const component_pool& pool = *m_reg.m_components[base.cid];
+	size_t size				   = pool.component_size();
+	write_varint(out, size);
+
+	std::vector<entity_id> removed;
+	for (entity_id id : base.ents.ids) {
+		if (!pool.contains(id) && m_reg.valid(id)) removed.push_back(id);
+	}
+	write_ids(out, removed);
+
+	std::vector<char> now(pool.count() * size);
+	std::vector<char> added;
+	std::vector<char> changed;
+	size_t added_count	 = 0;
+	size_t changed_count = 0;
+	for (size_t i = 0; i < pool.count(); ++i) {
+		entity_id id	  = pool.entities()[i];
+		char* component	  = now.data() + i * size;
+		std::memcpy(component, component_bytes(pool, i), size);
+		size_t prev = base.ents.find(id);
+		if (prev == sparse_set::npos) {
+			write_bytes(added, id);
+			added.insert(added.end(), component, component + size);
+			added_count++;
+		} else if (std::memcmp(component, base.bytes.data() + prev * size, size) != 0) {
+			write_bytes(changed, id);
+			write_xor(changed, component, base.bytes.data() + prev * size, size);
+			changed_count++;
+		}
+	}
+	write_varint(out, added_count);
+	out.insert(out.end(), added.begin(), added.end());
+	write_varint(out, changed_count);
+	out.insert(out.end(), changed.begin(), changed.end());
+
+	base.ents.assign(pool.entities());
+	base.bytes.swap(now);
+	return !removed.empty() || added_count != 0 || changed_count != 0;
+}
+
+const char* delta_encoder::component_bytes(const component_pool& pool, size_t idx) {
+	if (!pool.soa()) {
+		return pool.field(0, idx);
+	}
+	m_scratch.resize(pool.component_size());
+	pool.load(idx, m_scratch.data());
+	return m_scratch.data();
+}
+
+void delta_encoder::reset() {
+	m_entities.assign({});
+	m_pools.clear();
+	m_tick = 0;
+}
+
+uint64_t delta_encoder::tick() const {
+	return m_tick;
+}
+
+delta_decoder::delta_decoder(registry& r)
+	: m_reg(r),
+	  m_tick(0) {
+}
+
+void delta_decoder::apply(std::span<const char> delta) {
+	byte_reader in(delta.data(), delta.size());
+	if (std::memcmp(in.bytes(sizeof(DELTA_MAGIC)), DELTA_MAGIC, sizeof(DELTA_MAGIC)) != 0 ||
+		in.read<uint32_t>() != DELTA_VERSION) {
+		throw std::runtime_error("Not a delta of this version.");
+	}
+	uint64_t base = in.read<uint64_t>();
+	uint64_t tick = in.read<uint64_t>();
+	if (base != 0 && base != m_tick) {
+		throw std::runtime_error("Delta was not encoded against the last one applied.");
+	}
+	std::vector<entity_id> destroyed = read_ids(in);
+	std::vector<entity_id> created	 = read_ids(in);
+
+	/// the changes to one pool, pointing into the delta
+	struct pool_delta {
+		size_t cid;
+		const registry::snapshot_type* type;
+		size_t size;
+		std::vector<entity_id> removed;
+		std::vector<std::pair<entity_id, const char*>> added;
+		/// the entity, its runs, and their length
+		std::vector<std::tuple<entity_id, const char*, size_t>> changed;
+	};
+	// read everything before touching the replica
+	size_t pool_count = in.read_varint();
+	if (pool_count > in.remaining()) {
+		throw std::runtime_error("Data is truncated.");
+	}
+	std::vector<pool_delta> pools(pool_count);
+	for (pool_delta& p : pools) {
+		size_t name_len = in.read_varint();
+		std::string name(in.bytes(name_len), name_len);
+		auto it = std::find_if(m_reg.m_snapshot_types.begin(), m_reg.m_snapshot_types.end(), [&name](const auto& t) {
+			return t.second.raw && t.second.name == name;
+		});
+		if (it == m_reg.m_snapshot_types.end()) {
+			throw std::runtime_error("Component type " + name + " of the delta is not registered.");
+		}
+		p.cid  = it->first;
+		p.type = &it->second;
+		p.size = in.read_varint();
+		if (std::any_of(pools.begin(), pools.end(), [&p](const pool_delta& other) { return &other != &p && other.type == p.type; })) {
+			throw std::runtime_error("Component type " + name + " is twice in the delta.");
+		}
+		if (p.size != p.type->size) {
+			throw std::runtime_error("Component type " + name + " has a different size than in the delta.");
+		}
+		p.removed = read_ids(in);
+		size_t added = in.read_varint();
+		if (added > in.remaining() / (sizeof(entity_id) + p.size)) {
+			throw std::runtime_error("Data is truncated.");
+		}
+		p.added.resize(added);
+		for (auto& [id, bytes] : p.added) {
+			id	  = in.read<entity_id>();
+			bytes = in.bytes(p.size);
+		}
+		size_t changed = in.read_varint();
+		if (changed > in.remaining() / sizeof(entity_id)) {
+			throw std::runtime_error("Data is truncated.");
+		}
+		p.changed.resize(changed);
+		for (auto& [id, runs, len] : p.changed) {
+			id	 = in.read<entity_id>();
+			len	 = in.read_varint();
+			runs = in.bytes(len);
+		}
+	}
+	if (!in.done()) {
+		throw std::runtime_error("Delta has trailing bytes.");
+	}
+
+	// check every change against what the replica will hold, so applying can't fail halfway.
+	// the sets are keyed by entity index, as the replica holds at most one entity per index
+	auto key = [](entity_id id) {
+		return make_entity_id(entity_index(id), 0);
+	};
+	sparse_set freed(m_reg.m_resource);
+	sparse_set fresh(m_reg.m_resource);
+	std::vector<entity_id> dying;
+	if (base != 0) {
+		for (entity_id id : destroyed) {
+			if (m_reg.valid(id) && !freed.contains(key(id))) {
+				freed.insert(key(id));
+				dying.push_back(id);
+			}
+		}
+	}
+	for (entity_id id : created) {
+		size_t idx = entity_index(id);
+		bool taken = base != 0 && idx < m_reg.m_next_index &&
+					 (idx >= m_reg.m_free_slots.size() || m_reg.m_free_slots[idx] == sparse_set::npos) && !freed.contains(key(id));
+		if (idx >= ENTITY_INDEX_MASK || taken || fresh.contains(key(id))) {
+			throw std::runtime_error("Delta creates an entity whose index is in use.");
+		}
+		fresh.insert(key(id));
+	}
+	// created ids are at the same positions in fresh
+	auto alive = [&](entity_id id) {
+		size_t pos = fresh.find(key(id));
+		if (pos != sparse_set::npos) return created[pos] == id;
+		return base != 0 && m_reg.valid(id) && !freed.contains(key(id));
+	};
+	for (const pool_delta& p : pools) {
+		const component_pool* pool = p.cid < m_reg.m_components.size() ? m_reg.m_components[p.cid].get() : nullptr;
+		auto had = [&](entity_id id) {
+			return base != 0 && pool && pool->contains(id) && !freed.contains(key(id));
+		};
+		sparse_set gone(m_reg.m_resource);
+		sparse_set put(m_reg.m_resource);
+		for (entity_id id : p.removed) {
+			if (had(id) && !gone.contains(key(id))) gone.insert(key(id));
+		}
+		for (const auto& [id, bytes] : p.added) {
+			if (!alive(id) || (had(id) && !gone.contains(key(id))) || put.contains(key(id))) {
+				throw std::runtime_error("Delta adds a component to an entity that can't take it.");
+			}
+			put.insert(key(id));
+		}
+		size_t kept = 0;
+		if (base != 0 && pool) {
+			kept = pool->count() - gone.size() - std::count_if(dying.begin(), dying.end(), [pool](entity_id id) {
+					   return pool->contains(id);
+				   });
+		}
+		if (kept + put.size() > m_reg.MAX_COMPONENTS) {
+			throw std::out_of_range("Delta adds more components than the replica can hold.");
+		}
+		for (const auto& [id, runs, len] : p.changed) {
+			if (!alive(id) || !((had(id) && !gone.contains(key(id))) || put.contains(key(id)))) {
+				throw std::runtime_error("Delta changes a component the replica doesn't have.");
+			}
+			check_xor(p.size, runs, len);
+		}
+	}
+
+	if (base == 0) {
+		// a delta of everything replaces what the replica has
+		std::vector<entity_id> all(m_reg.entities().begin(), m_reg.entities().end());
+		for (entity_id id : all) {
+			m_reg.remove(m_reg.at(id));
+		}
+	}
+	for (entity_id id : destroyed) {
+		if (m_reg.valid(id)) m_reg.remove(m_reg.at(id));
+	}
+	for (entity_id id : created) {
+		m_reg.create(id);
+	}
+	std::vector<char> scratch;
+	for (const pool_delta& p : pools) {
+		component_pool& pool = p.type->assure(m_reg);
+		for (entity_id id : p.removed) {
+			if (!pool.contains(id)) continue;
+			m_reg.removing(p.cid, id);
+			pool.remove(id);
+		}
+		for (const auto& [id, bytes] : p.added) {
+			p.type->emplace(m_reg, id, bytes);
+		}
+		for (const auto& [id, runs, len] : p.changed) {
+			size_t idx = pool.index(id);
+			pool.touch(idx);
+			if (!pool.soa()) {
+				apply_xor(pool.field(0, idx), p.size, runs, len);
+			} else {
+				scratch.resize(p.size);
+				pool.load(idx, scratch.data());
+				apply_xor(scratch.data(), p.size, runs, len);
+				pool.store(idx, scratch.data());
+			}
+			m_reg.updated(p.cid, id);
+		}
+	}
+	m_tick = tick;
+}
+
+uint64_t delta_decoder::tick() const {
+	return m_tick;
+}
+
+}
@@ -4,64 +4,71 @@
 
 namespace ecs {
 
-entity::entity(registry& r)
-	: m_destroyed(false),
-	  m_reg(r),
-	  m_lookup() {
+entity::entity()
+	: m_reg(nullptr),
+	  m_id(null_entity) {
 }
 
-entity::~entity() {
-	destroy();
-}
-
-void entity::destroy() {
-	if (m_destroyed) return;
-	// remove all corresponding components
-	for (auto& [key, value] : m_lookup) {
-		m_reg.remove(key, value);
-	}
-	m_destroyed = true;
+entity::entity(registry& r, entity_id id)
+	: m_reg(&r),
+	  m_id(id) {
 }
 
 void entity::assert_alive() const {
-	if (m_destroyed) {
+	if (!alive()) {
 		throw std::runtime_error("Entity has been destroyed!");
 	}
 }
 
 bool entity::alive() const {
-	return !m_destroyed;
+	return m_reg && m_reg->valid(m_id);
 }
 
 entity_t entity::clone() const {
 	assert_alive();
-	auto ent = m_reg.create();
+	for (const auto& p : m_reg->m_components) {
+		if (p && p->contains(m_id) && !p->copyable()) {
+			throw std::runtime_error("Component can't be copied.");
+		}
+	}
+	auto ent = m_reg->create();
 	// for each component
-	for (auto& [ti, idx] : m_lookup) {
-		// get the relevant pool
-		component_pool& p = m_reg.pool(ti);
-		// clone the component
-		size_t slot = p.clone(idx);
-		// add it to the new entity
-		ent->m_lookup[ti] = slot;
+	for (size_t cid = 0; cid < m_reg->m_components.size(); ++cid) {
+		component_pool* p = m_reg->m_components[cid].get();
+		if (!p || !p->contains(m_id)) continue;
+		// clone the component into the new entity
+		p->clone(m_id, ent.m_id);
+		m_reg->added(cid, ent.m_id);
 	}
 	return ent;
 }
 
 size_t entity::lookup_id(std::type_index ti) const {
 	assert_alive();
-	return m_lookup.at(ti);
+	return m_reg->pool(ti).index(m_id);
+}
+
+entity_id entity::id() const {
+	return m_id;
+}
+
+entity* entity::operator->() {
+	return this;
+}
+
+const entity* entity::operator->() const {
+	return this;
 }
 
 bool entity::has(std::type_index ti) const {
 	assert_alive();
-	return m_lookup.contains(ti);
+	return m_reg->has(ti, m_id);
 }
 
 bool entity::has(std::vector<std::type_index> tis) const {
 	assert_alive();
 	return std::all_of(tis.begin(), tis.end(), [this](const std::type_index& ti) {
-		return m_lookup.contains(ti);
+		return m_reg->has(ti, m_id);
 	});
 }
 
@@ -0,0 +1,12 @@
+#include "internal/component_id.hpp"
+
+#include <atomic>
+
+namespace ecs {
+
+size_t next_component_id() {
+	static std::atomic<size_t> next(0);
+	return next++;
+}
+
+}
@@ -1,106 +1,332 @@
 #include "internal/component_pool.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <new>
 
 namespace ecs {
 
-component_pool::component_pool(size_t max_sz, size_t comp_sz)
+component_pool::component_pool(size_t max_sz, size_t comp_sz, std::vector<soa_field> fields, lifecycle ops,
+							   std::pmr::memory_resource* resource, size_t comp_align)
 	: MAX_SZ(max_sz),
 	  COMP_SZ(comp_sz),
-	  m_data(new char[max_sz * comp_sz]()),
-	  m_next_slot(0),
-	  m_storage_bitmask(new char[(max_sz / 8) + 1]()),
-	  m_count(0) {
+	  m_ops(ops),
+	  m_fields(),
+	  m_resource(resource),
+	  m_page_align(std::max(PAGE_ALIGN, comp_align)),
+	  m_page_bytes(0),
+	  m_pages(resource),
+	  m_set(resource),
+	  m_clock(nullptr),
+	  m_added(resource),
+	  m_changed(resource),
+	  m_page_added(resource),
+	  m_page_changed(resource) {
+	if (fields.empty()) {
+		fields.push_back(soa_field{ 0, comp_sz });
+	}
+	// lay the arrays of each field out one after the other, each starting on a page alignment boundary
+	for (const soa_field& f : fields) {
+		if (f.offset + f.size > comp_sz) {
+			throw std::out_of_range("Field does not fit in the component.");
+		}
+		m_fields.push_back(slice{ f.offset, f.size, m_page_bytes });
+		m_page_bytes += (PAGE_SZ * f.size + m_page_align - 1) / m_page_align * m_page_align;
+	}
+}
+
+std::pair<size_t, size_t> component_pool::page_layout(size_t comp_sz, const std::vector<soa_field>& fields, size_t comp_align) {
+	size_t align = std::max(PAGE_ALIGN, comp_align);
+	if (fields.empty()) {
+		return { (PAGE_SZ * comp_sz + align - 1) / align * align, align };
+	}
+	size_t bytes = 0;
+	for (const soa_field& f : fields) {
+		bytes += (PAGE_SZ * f.size + align - 1) / align * align;
+	}
+	return { bytes, align };
 }
 
 component_pool::~component_pool() {
-	delete[] m_data;
-	delete[] m_storage_bitmask;
+	if (m_ops.destroy) {
+		for (size_t i = 0; i < m_set.size(); ++i) {
+			destroy(i);
+		}
+	}
+}
+
+void component_pool::clone(entity_id from, entity_id to) {
+	if (!m_set.contains(from)) {
+		throw std::out_of_range("No component to clone!");
+	}
+	if (!copyable()) {
+		throw std::runtime_error("Component can't be copied.");
+	}
+	if (m_set.contains(to)) {
+		throw std::runtime_error("Component already exists.");
+	}
+	grow(m_set.size() + 1);
+	size_t src = m_set.index(from);
+	// inserted before copying, as in add()
+	size_t idx = m_set.insert(to);
+	try {
+		copy(idx, src);
+	} catch (...) {
+		m_set.remove(to);
+		throw;
+	}
+	stamp_new(idx);
+}
+
+void component_pool::remove(entity_id entity) {
+	if (!m_set.contains(entity)) {
+		throw std::runtime_error("Attempt to remove component that does not exist");
+	}
+	size_t idx	= m_set.index(entity);
+	size_t last = m_set.size() - 1;
+	destroy(idx);
+	// move the last component into the hole, mirroring the sparse set
+	if (idx != last) {
+		relocate(idx, last);
+		move_ticks(idx, last);
+	}
+	m_set.remove(entity);
+}
+
+void component_pool::swap(size_t a, size_t b) {
+	if (a == b) return;
+	if (m_ops.swap) {
+		m_ops.swap(field(0, a), field(0, b));
+	} else {
+		for (size_t f = 0; f < m_fields.size(); ++f) {
+			std::swap_ranges(field(f, a), field(f, a) + m_fields[f].size, field(f, b));
+		}
+	}
+	m_set.swap(a, b);
+	if (m_clock) {
+		std::swap(m_added[a], m_added[b]);
+		std::swap(m_changed[a], m_changed[b]);
+		for (size_t i : { a, b }) {
+			raise(m_page_added[i / PAGE_SZ], m_added[i]);
+			raise(m_page_changed[i / PAGE_SZ], m_changed[i]);
+		}
+	}
+}
+
+size_t component_pool::shrink_to_fit() {
+	size_t needed	= (m_set.size() + PAGE_SZ - 1) / PAGE_SZ;
+	size_t released = (m_pages.size() - std::min(needed, m_pages.size())) * m_page_bytes;
+	if (m_pages.size() > needed) {
+		m_pages.resize(needed);
+	}
+	m_pages.shrink_to_fit();
+	fit_ticks();
+	return released + m_set.shrink_to_fit();
+}
+
+bool component_pool::arrange(const std::vector<entity_id>& order, size_t& pos, size_t budget) {
+	if (order.size() != m_set.size()) return false;
+	for (size_t end = std::min(order.size(), pos + budget); pos < end; ++pos) {
+		size_t idx = m_set.find(order[pos]);
+		// positions before pos are already arranged, so the entity can't be there
+		if (idx == sparse_set::npos || idx < pos) return false;
+		swap(pos, idx);
+	}
+	return true;
+}
+
+void component_pool::adopt(const entity_id* ents, size_t n, const std::vector<char*>& pages) {
+	if (m_set.size() != 0) {
+		throw std::runtime_error("Only an empty pool can adopt pages.");
+	}
+	if (!trivial()) {
+		throw std::runtime_error("Only pools of trivial components can adopt pages.");
+	}
+	if (n > MAX_SZ || pages.size() != (n + PAGE_SZ - 1) / PAGE_SZ) {
+		throw std::out_of_range("Wrong amount of pages to adopt.");
+	}
+	m_pages.clear();
+	for (char* page : pages) {
+		m_pages.emplace_back(page, page_deleter{ nullptr, m_page_bytes, m_page_align });
+	}
+	m_set.reserve(n);
+	fit_ticks();
+	for (size_t i = 0; i < n; ++i) {
+		stamp_new(m_set.insert(ents[i]));
+	}
+}
+
+const char* component_pool::page(size_t i) const {
+	return m_pages[i].get();
+}
+
+size_t component_pool::page_bytes() const {
+	return m_page_bytes;
+}
+
+size_t component_pool::page_align() const {
+	return m_page_align;
+}
+
+size_t component_pool::component_size() const {
+	return COMP_SZ;
+}
+
+void component_pool::track(const uint64_t* clock) {
+	if (m_clock) return;
+	m_clock = clock;
+	fit_ticks();
+}
+
+bool component_pool::tracked() const {
+	return m_clock != nullptr;
 }
 
-size_t component_pool::clone(size_t idx) {
-	if (m_next_slot >= MAX_SZ) {
+uint64_t component_pool::added_at(size_t idx) const {
+	return m_added[idx];
+}
+
+uint64_t component_pool::changed_at(size_t idx) const {
+	return m_changed[idx];
+}
+
+uint64_t component_pool::page_added_at(size_t i) const {
+	// may be raised concurrently, by components moving in
+	return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(m_page_added[i])).load(std::memory_order_relaxed);
+}
+
+uint64_t component_pool::page_changed_at(size_t i) const {
+	// may be raised concurrently, by par_each() handing out components of the same page
+	return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(m_page_changed[i])).load(std::memory_order_relaxed);
+}
+
+bool component_pool::trivial() const {
+	return !m_ops.copy && !m_ops.relocate && !m_ops.swap && !m_ops.destroy && m_ops.copyable;
+}
+
+void component_pool::reserve(size_t n) {
+	grow(n);
+	m_set.reserve(n);
+}
+
+void component_pool::grow(size_t n) {
+	if (n > MAX_SZ) {
 		throw std::out_of_range(
 			"Not enough room in the component pool! \
 				(make the max size larger)");
 	}
-	if (!is_set(idx)) {
-		throw std::out_of_range("No component to clone!");
+	while (capacity() < n) {
+		char* page = static_cast<char*>(m_resource->allocate(m_page_bytes, m_page_align));
+		std::memset(page, 0, m_page_bytes);
+		m_pages.emplace_back(page, page_deleter{ m_resource, m_page_bytes, m_page_align });
 	}
-	size_t slot = m_next_slot;
-	// clone every bit
-	std::memcpy(m_data + (slot * COMP_SZ), m_data + (idx * COMP_SZ), COMP_SZ);
-	set_bit(slot);
-	find_free_slot();
-	m_count++;
-	return slot;
+	fit_ticks();
+}
+
+size_t component_pool::capacity() const {
+	return m_pages.size() * PAGE_SZ;
+}
+
+bool component_pool::contains(entity_id entity) const {
+	return m_set.contains(entity);
+}
+
+size_t component_pool::index(entity_id entity) const {
+	return m_set.index(entity);
+}
+
+size_t component_pool::find(entity_id entity) const {
+	return m_set.find(entity);
+}
+
+const std::pmr::vector<entity_id>& component_pool::entities() const {
+	return m_set.dense();
+}
+
+size_t component_pool::count() const {
+	return m_set.size();
 }
 
-void component_pool::remove(size_t idx) {
-	if (idx >= MAX_SZ) {
-		throw std::out_of_range("Attempt to remove a component out of range.");
+bool component_pool::copyable() const {
+	return m_ops.copyable;
+}
+
+bool component_pool::soa() const {
+	return m_fields.size() > 1 || m_fields.front().size != COMP_SZ;
+}
+
+void component_pool::store(size_t idx, const void* component) {
+	const char* src = static_cast<const char*>(component);
+	for (size_t f = 0; f < m_fields.size(); ++f) {
+		std::memcpy(field(f, idx), src + m_fields[f].offset, m_fields[f].size);
 	}
-	if (!is_set(idx)) {
-		throw std::runtime_error("Attempt to remove component that does not exist");
+}
+
+void component_pool::load(size_t idx, void* out) const {
+	char* dst = static_cast<char*>(out);
+	for (size_t f = 0; f < m_fields.size(); ++f) {
+		std::memcpy(dst + m_fields[f].offset, field(f, idx), m_fields[f].size);
 	}
-	// unset that bit
-	unset_bit(idx);
-	m_count--;
-	// if this slot is earlier than the current next available slot,
-	if (m_next_slot > idx) {
-		//..then update this to be the next free slot
-		m_next_slot = idx;
+}
+
+void component_pool::page_deleter::operator()(char* page) const {
+	if (resource) {
+		resource->deallocate(page, bytes, align);
 	}
 }
 
-size_t component_pool::count() const {
-	return m_count;
-}
-
-void component_pool::set_bit(size_t idx) {
-	// split index into byte and bit lookup
-	size_t byte_idx = idx / 8;
-	size_t bit_idx	= idx % 8;
-	// get byte
-	char& byte = m_storage_bitmask[byte_idx];
-	// set that bit to 1
-	byte |= (1 << bit_idx);
-}
-
-void component_pool::unset_bit(size_t idx) {
-	// split index into byte and bit lookup
-	size_t byte_idx = idx / 8;
-	size_t bit_idx	= idx % 8;
-	// get byte
-	char& byte = m_storage_bitmask[byte_idx];
-	// set that bit to 0
-	byte &= ~(1 << bit_idx);
-}
-
-bool component_pool::is_set(size_t idx) const {
-	// split index into byte and bit lookup
-	size_t byte_idx = idx / 8;
-	size_t bit_idx	= idx % 8;
-	// get byte
-	char& byte = m_storage_bitmask[byte_idx];
-	return byte & (1 << bit_idx);
-}
-
-void component_pool::find_free_slot() {
-	// get the current bitmask byte
-	size_t byte_idx = m_next_slot / 8;
-	// iterate from this byte to the end
-	for (size_t i = byte_idx; i < MAX_SZ; ++i) {
-		// ignore if this byte is entirely full
-		char byte = m_storage_bitmask[i];
-		if (byte == (char)0xFF) continue;
-		for (size_t j = 0; j < 8; ++j) {
-			if (byte & (1 << j)) continue;
-			m_next_slot = i * 8 + j;
-			return;
-		}
+void component_pool::copy(size_t dst, size_t src) {
+	if (m_ops.copy) {
+		m_ops.copy(field(0, dst), field(0, src));
+		return;
+	}
+	for (size_t f = 0; f < m_fields.size(); ++f) {
+		std::memcpy(field(f, dst), field(f, src), m_fields[f].size);
 	}
-	throw std::runtime_error("No free slots available.");
+}
+
+void component_pool::relocate(size_t dst, size_t src) {
+	if (m_ops.relocate) {
+		m_ops.relocate(field(0, dst), field(0, src));
+		return;
+	}
+	for (size_t f = 0; f < m_fields.size(); ++f) {
+		std::memcpy(field(f, dst), field(f, src), m_fields[f].size);
+	}
+}
+
+void component_pool::destroy(size_t idx) {
+	if (m_ops.destroy) {
+		m_ops.destroy(field(0, idx));
+	}
+}
+
+void component_pool::fit_ticks() {
+	if (!m_clock || m_page_added.size() == m_pages.size()) return;
+	m_added.resize(capacity());
+	m_changed.resize(capacity());
+	m_page_added.resize(m_pages.size());
+	m_page_changed.resize(m_pages.size());
+	m_added.shrink_to_fit();
+	m_changed.shrink_to_fit();
+	m_page_added.shrink_to_fit();
+	m_page_changed.shrink_to_fit();
+}
+
+void component_pool::stamp_new(size_t idx) {
+	if (!m_clock) return;
+	m_added[idx]   = *m_clock;
+	m_changed[idx] = *m_clock;
+	raise(m_page_added[idx / PAGE_SZ], *m_clock);
+	raise(m_page_changed[idx / PAGE_SZ], *m_clock);
+}
+
+void component_pool::move_ticks(size_t dst, size_t src) {
+	if (!m_clock) return;
+	m_added[dst]   = m_added[src];
+	m_changed[dst] = m_changed[src];
+	raise(m_page_added[dst / PAGE_SZ], m_added[dst]);
+	raise(m_page_changed[dst / PAGE_SZ], m_changed[dst]);
 }
 
 }
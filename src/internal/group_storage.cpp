@@ -0,0 +1,59 @@
+#include "internal/group_storage.hpp"
+
+#include <algorithm>
+
+namespace ecs {
+
+group_storage::group_storage(std::vector<size_t> owned, std::vector<component_pool*> pools)
+	: m_owned(std::move(owned)),
+	  m_pools(std::move(pools)),
+	  m_size(0) {
+	// walk the smallest pool, packing every entity that has all the components
+	component_pool* smallest = *std::min_element(m_pools.begin(), m_pools.end(), [](component_pool* a, component_pool* b) {
+		return a->count() < b->count();
+	});
+	// copied, as packing reorders the pool
+	std::vector<entity_id> candidates(smallest->entities().begin(), smallest->entities().end());
+	for (entity_id id : candidates) {
+		added(id);
+	}
+}
+
+bool group_storage::owns(size_t cid) const {
+	return std::find(m_owned.begin(), m_owned.end(), cid) != m_owned.end();
+}
+
+const std::vector<size_t>& group_storage::owned() const {
+	return m_owned;
+}
+
+size_t group_storage::size() const {
+	return m_size;
+}
+
+bool group_storage::contains(entity_id id) const {
+	const component_pool& p = *m_pools.front();
+	return p.contains(id) && p.index(id) < m_size;
+}
+
+void group_storage::added(entity_id id) {
+	if (contains(id)) return;
+	for (component_pool* p : m_pools) {
+		if (!p->contains(id)) return;
+	}
+	move_to(id, m_size++);
+}
+
+void group_storage::removing(entity_id id) {
+	if (!contains(id)) return;
+	// swap with the last member, then shrink the prefix past it
+	move_to(id, --m_size);
+}
+
+void group_storage::move_to(entity_id id, size_t idx) {
+	for (component_pool* p : m_pools) {
+		p->swap(p->index(id), idx);
+	}
+}
+
+}
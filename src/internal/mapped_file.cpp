@@ -0,0 +1,79 @@
+#include "internal/mapped_file.hpp"
+
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ECS_HAS_MMAP 1
+#else
+/// the alignment of the buffer a file is read into when it can't be mapped
+static constexpr size_t READ_ALIGN = 4096;
+#endif
+
+namespace ecs {
+
+mapped_file::mapped_file(const std::string& path)
+	: m_data(nullptr),
+	  m_size(0),
+	  m_mapped(false) {
+#ifdef ECS_HAS_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Could not open " + path + ".");
+	}
+	struct stat st;
+	if (::fstat(fd, &st) != 0) {
+		::close(fd);
+		throw std::runtime_error("Could not read the size of " + path + ".");
+	}
+	m_size = static_cast<size_t>(st.st_size);
+	if (m_size > 0) {
+		// private so pools can modify adopted pages without touching the file
+		void* p = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			::close(fd);
+			throw std::runtime_error("Could not map " + path + ".");
+		}
+		m_data	 = static_cast<char*>(p);
+		m_mapped = true;
+	}
+	::close(fd);
+#else
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in) {
+		throw std::runtime_error("Could not open " + path + ".");
+	}
+	m_size = static_cast<size_t>(in.tellg());
+	in.seekg(0);
+	m_data = static_cast<char*>(::operator new[](m_size, std::align_val_t(READ_ALIGN)));
+	if (!in.read(m_data, m_size)) {
+		::operator delete[](m_data, std::align_val_t(READ_ALIGN));
+		throw std::runtime_error("Could not read " + path + ".");
+	}
+#endif
+}
+
+mapped_file::~mapped_file() {
+#ifdef ECS_HAS_MMAP
+	if (m_mapped) {
+		::munmap(m_data, m_size);
+	}
+#else
+	::operator delete[](m_data, std::align_val_t(READ_ALIGN));
+#endif
+}
+
+char* mapped_file::data() const {
+	return m_data;
+}
+
+size_t mapped_file::size() const {
+	return m_size;
+}
+
+}
@@ -0,0 +1,45 @@
+#include "internal/query_storage.hpp"
+
+#include <utility>
+
+namespace ecs {
+
+query_storage::query_storage(component_mask required, component_mask excluded, const signature_set& signatures,
+							 std::pmr::memory_resource* resource)
+	: m_required(std::move(required)),
+	  m_excluded(std::move(excluded)),
+	  m_signatures(&signatures),
+	  m_set(resource) {
+}
+
+bool query_storage::caches(const component_mask& required, const component_mask& excluded) const {
+	return m_required == required && m_excluded == excluded;
+}
+
+bool query_storage::watches(size_t cid) const {
+	return m_required.test(cid) || m_excluded.test(cid);
+}
+
+void query_storage::update(entity_id id) {
+	bool matches = m_signatures->matches(entity_index(id), m_required, m_excluded);
+	if (matches == m_set.contains(id)) return;
+	if (matches) {
+		m_set.insert(id);
+	} else {
+		m_set.remove(id);
+	}
+}
+
+const std::pmr::vector<entity_id>& query_storage::entities() const {
+	return m_set.dense();
+}
+
+size_t query_storage::size() const {
+	return m_set.size();
+}
+
+bool query_storage::contains(entity_id id) const {
+	return m_set.contains(id);
+}
+
+}
@@ -0,0 +1,64 @@
+#include "internal/signal.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <entity.hpp>
+#include <observer.hpp>
+#include <registry.hpp>
+
+namespace ecs {
+
+signal::signal()
+	: m_listeners(),
+	  m_next_id(0) {
+}
+
+size_t signal::connect(std::function<void(entity_id)> listener) {
+	m_listeners.emplace_back(m_next_id, std::move(listener));
+	return m_next_id++;
+}
+
+void signal::disconnect(size_t id) {
+	auto it = std::find_if(m_listeners.begin(), m_listeners.end(), [id](const auto& l) {
+		return l.first == id;
+	});
+	if (it != m_listeners.end()) {
+		m_listeners.erase(it);
+	}
+}
+
+bool signal::empty() const {
+	return m_listeners.empty();
+}
+
+sink::sink(registry& r, signal& s)
+	: m_reg(&r),
+	  m_signal(&s) {
+}
+
+size_t sink::connect(std::function<void(entity_t)> listener) {
+	return m_signal->connect([reg = m_reg, listener = std::move(listener)](entity_id id) {
+		listener(reg->handle(id));
+	});
+}
+
+void sink::disconnect(size_t id) {
+	m_signal->disconnect(id);
+}
+
+void sink::collect(observer& obs) {
+	if (obs.m_reg && obs.m_reg != m_reg) {
+		throw std::runtime_error("Observer already collects from another registry.");
+	}
+	obs.m_reg = m_reg;
+	if (obs.m_connections.empty()) {
+		m_reg->m_observers.push_back(&obs);
+	}
+	size_t id = m_signal->connect([&obs](entity_id id) {
+		obs.record(id);
+	});
+	obs.m_connections.emplace_back(m_signal, id);
+}
+
+}
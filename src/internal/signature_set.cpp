@@ -0,0 +1,112 @@
+#include "internal/signature_set.hpp"
+
+#include <algorithm>
+
+namespace ecs {
+
+component_mask::component_mask(std::initializer_list<size_t> cids) {
+	for (size_t cid : cids) {
+		set(cid);
+	}
+}
+
+void component_mask::set(size_t cid) {
+	if (cid < WORD_BITS) {
+		m_low |= uint64_t(1) << cid;
+		return;
+	}
+	size_t w = cid / WORD_BITS - 1;
+	if (w >= m_high.size()) {
+		m_high.resize(w + 1);
+	}
+	m_high[w] |= uint64_t(1) << (cid % WORD_BITS);
+}
+
+bool component_mask::test(size_t cid) const {
+	if (cid < WORD_BITS) {
+		return (m_low >> cid) & 1;
+	}
+	size_t w = cid / WORD_BITS - 1;
+	return w < m_high.size() && ((m_high[w] >> (cid % WORD_BITS)) & 1);
+}
+
+bool component_mask::operator==(const component_mask& other) const {
+	if (m_low != other.m_low) return false;
+	// trailing zero words don't count
+	size_t words = std::max(m_high.size(), other.m_high.size());
+	for (size_t w = 0; w < words; ++w) {
+		uint64_t a = w < m_high.size() ? m_high[w] : 0;
+		uint64_t b = w < other.m_high.size() ? other.m_high[w] : 0;
+		if (a != b) return false;
+	}
+	return true;
+}
+
+bool component_mask::empty() const {
+	return m_low == 0 && std::all_of(m_high.begin(), m_high.end(), [](uint64_t w) { return w == 0; });
+}
+
+signature_set::signature_set(std::pmr::memory_resource* resource)
+	: m_low(resource),
+	  m_high(resource),
+	  m_stride(0) {
+}
+
+void signature_set::set(size_t idx, size_t cid) {
+	if (idx >= m_low.size()) {
+		m_low.resize(idx + 1);
+	}
+	if (cid < component_mask::WORD_BITS) {
+		m_low[idx] |= uint64_t(1) << cid;
+		return;
+	}
+	size_t w = cid / component_mask::WORD_BITS - 1;
+	if (w >= m_stride) {
+		// widen every entity's high words, keeping the bits already set
+		size_t stride = w + 1;
+		std::pmr::vector<uint64_t> wider(m_low.size() * stride, 0, m_high.get_allocator());
+		for (size_t i = 0; i * m_stride < m_high.size(); ++i) {
+			std::copy_n(m_high.begin() + i * m_stride, m_stride, wider.begin() + i * stride);
+		}
+		m_high.swap(wider);
+		m_stride = stride;
+	}
+	if (m_high.size() < m_low.size() * m_stride) {
+		m_high.resize(m_low.size() * m_stride);
+	}
+	m_high[idx * m_stride + w] |= uint64_t(1) << (cid % component_mask::WORD_BITS);
+}
+
+void signature_set::reset(size_t idx, size_t cid) {
+	if (idx >= m_low.size()) return;
+	if (cid < component_mask::WORD_BITS) {
+		m_low[idx] &= ~(uint64_t(1) << cid);
+		return;
+	}
+	size_t w = cid / component_mask::WORD_BITS - 1;
+	if (w < m_stride && idx * m_stride + w < m_high.size()) {
+		m_high[idx * m_stride + w] &= ~(uint64_t(1) << (cid % component_mask::WORD_BITS));
+	}
+}
+
+bool signature_set::test(size_t idx, size_t cid) const {
+	if (idx >= m_low.size()) return false;
+	if (cid < component_mask::WORD_BITS) {
+		return (m_low[idx] >> cid) & 1;
+	}
+	size_t w = cid / component_mask::WORD_BITS - 1;
+	return w < m_stride && idx * m_stride + w < m_high.size() && ((m_high[idx * m_stride + w] >> (cid % component_mask::WORD_BITS)) & 1);
+}
+
+bool signature_set::matches_high(size_t idx, const component_mask& required, const component_mask& excluded) const {
+	size_t words = std::max(required.high().size(), excluded.high().size());
+	for (size_t w = 0; w < words; ++w) {
+		uint64_t sig = w < m_stride && idx * m_stride + w < m_high.size() ? m_high[idx * m_stride + w] : 0;
+		uint64_t req = w < required.high().size() ? required.high()[w] : 0;
+		uint64_t exc = w < excluded.high().size() ? excluded.high()[w] : 0;
+		if ((sig & req) != req || (sig & exc) != 0) return false;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,113 @@
+#include "internal/sparse_set.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ecs {
+
+sparse_set::sparse_set(std::pmr::memory_resource* resource)
+	: m_resource(resource),
+	  m_dense(resource),
+	  m_sparse(resource) {
+}
+
+size_t sparse_set::insert(entity_id id) {
+	size_t& entry = assure(id);
+	if (entry != npos) {
+		throw std::runtime_error("Id already exists in the sparse set.");
+	}
+	entry = m_dense.size();
+	m_dense.push_back(id);
+	return entry;
+}
+
+void sparse_set::remove(entity_id id) {
+	if (!contains(id)) {
+		throw std::out_of_range("Attempt to remove an id not in the sparse set.");
+	}
+	// move the last id into the removed slot, keeping the dense array packed
+	size_t idx	   = index(id);
+	entity_id last = m_dense.back();
+	m_dense[idx]   = last;
+	assure(last)   = idx;
+	m_dense.pop_back();
+	assure(id) = npos;
+}
+
+void sparse_set::swap(size_t a, size_t b) {
+	std::swap(m_dense[a], m_dense[b]);
+	assure(m_dense[a]) = a;
+	assure(m_dense[b]) = b;
+}
+
+bool sparse_set::contains(entity_id id) const {
+	return find(id) != npos;
+}
+
+size_t sparse_set::index(entity_id id) const {
+	size_t pos = find(id);
+	if (pos == npos) {
+		throw std::out_of_range("Id does not exist in the sparse set.");
+	}
+	return pos;
+}
+
+size_t sparse_set::find(entity_id id) const {
+	size_t idx	= entity_index(id);
+	size_t page = idx / PAGE_SZ;
+	if (page >= m_sparse.size() || !m_sparse[page]) return npos;
+	size_t pos = m_sparse[page][idx % PAGE_SZ];
+	return pos != npos && m_dense[pos] == id ? pos : npos;
+}
+
+void sparse_set::reserve(size_t n) {
+	m_dense.reserve(n);
+}
+
+size_t sparse_set::shrink_to_fit() {
+	size_t released = (m_dense.capacity() - m_dense.size()) * sizeof(entity_id);
+	m_dense.shrink_to_fit();
+	std::vector<bool> used(m_sparse.size(), false);
+	for (entity_id id : m_dense) {
+		used[entity_index(id) / PAGE_SZ] = true;
+	}
+	for (size_t page = 0; page < m_sparse.size(); ++page) {
+		if (m_sparse[page] && !used[page]) {
+			m_sparse[page].reset();
+			released += PAGE_SZ * sizeof(size_t);
+		}
+	}
+	// drop the trailing empty pages entirely
+	while (!m_sparse.empty() && !m_sparse.back()) {
+		m_sparse.pop_back();
+	}
+	return released;
+}
+
+size_t sparse_set::size() const {
+	return m_dense.size();
+}
+
+const std::pmr::vector<entity_id>& sparse_set::dense() const {
+	return m_dense;
+}
+
+size_t& sparse_set::assure(entity_id id) {
+	size_t idx	= entity_index(id);
+	size_t page = idx / PAGE_SZ;
+	if (page >= m_sparse.size()) {
+		m_sparse.resize(page + 1);
+	}
+	if (!m_sparse[page]) {
+		size_t* entries = static_cast<size_t*>(m_resource->allocate(PAGE_SZ * sizeof(size_t), alignof(size_t)));
+		std::fill_n(entries, PAGE_SZ, npos);
+		m_sparse[page] = std::unique_ptr<size_t[], page_deleter>(entries, page_deleter{ m_resource });
+	}
+	return m_sparse[page][idx % PAGE_SZ];
+}
+
+void sparse_set::page_deleter::operator()(size_t* page) const {
+	resource->deallocate(page, PAGE_SZ * sizeof(size_t), alignof(size_t));
+}
+
+}
@@ -0,0 +1,143 @@
+#include "internal/thread_pool.hpp"
+
+namespace ecs {
+
+namespace {
+/// the pool the current thread works for, if any
+thread_local const thread_pool* t_pool = nullptr;
+/// the index of the current thread in t_pool
+thread_local size_t t_index = 0;
+}
+
+thread_pool::thread_pool(size_t threads)
+	: m_queues(),
+	  m_threads(),
+	  m_queued(0),
+	  m_stop(false) {
+	if (threads == 0) threads = 1;
+	for (size_t i = 0; i < threads; ++i) {
+		m_queues.emplace_back(new queue());
+	}
+	for (size_t i = 0; i < threads; ++i) {
+		m_threads.emplace_back(&thread_pool::work, this, i);
+	}
+}
+
+thread_pool::~thread_pool() {
+	{
+		std::lock_guard<std::mutex> lk(m_sleep_mtx);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto& t : m_threads) {
+		t.join();
+	}
+}
+
+void thread_pool::run(size_t n, const std::function<void(size_t)>& task) {
+	if (n == 0) return;
+	if (n == 1) {
+		task(0);
+		return;
+	}
+	batch b;
+	b.task		= &task;
+	b.remaining = n;
+	// count the jobs before queueing them, so m_queued never underflows
+	{
+		std::lock_guard<std::mutex> lk(m_sleep_mtx);
+		m_queued += n;
+	}
+	// deal the jobs out over the queues
+	for (size_t i = 0; i < n; ++i) {
+		queue& q = *m_queues[i % m_queues.size()];
+		std::lock_guard<std::mutex> lk(q.mtx);
+		q.jobs.push_back(job{ &b, i });
+	}
+	m_wake.notify_all();
+	// help out until nothing is left to take, then wait for the rest to finish
+	size_t me = self();
+	job j;
+	while (b.remaining > 0 && try_pop(me, j)) {
+		execute(j);
+	}
+	{
+		std::unique_lock<std::mutex> lk(b.mtx);
+		b.done.wait(lk, [&b]() { return b.remaining == 0; });
+	}
+	if (b.error) {
+		std::rethrow_exception(b.error);
+	}
+}
+
+size_t thread_pool::size() const {
+	return m_threads.size();
+}
+
+size_t thread_pool::current_worker() const {
+	return self();
+}
+
+void thread_pool::work(size_t self) {
+	t_pool	= this;
+	t_index = self;
+	job j;
+	while (true) {
+		if (try_pop(self, j)) {
+			execute(j);
+			continue;
+		}
+		std::unique_lock<std::mutex> lk(m_sleep_mtx);
+		m_wake.wait(lk, [this]() { return m_stop || m_queued > 0; });
+		if (m_stop && m_queued == 0) return;
+	}
+}
+
+bool thread_pool::try_pop(size_t self, job& out) {
+	if (m_queued == 0) return false;
+	// newest job of our own queue first
+	if (self < m_queues.size()) {
+		queue& q = *m_queues[self];
+		std::lock_guard<std::mutex> lk(q.mtx);
+		if (!q.jobs.empty()) {
+			out = q.jobs.back();
+			q.jobs.pop_back();
+			m_queued--;
+			return true;
+		}
+	}
+	// then steal the oldest job of another
+	for (size_t k = 1; k <= m_queues.size(); ++k) {
+		queue& q = *m_queues[(self + k) % m_queues.size()];
+		std::lock_guard<std::mutex> lk(q.mtx);
+		if (!q.jobs.empty()) {
+			out = q.jobs.front();
+			q.jobs.pop_front();
+			m_queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void thread_pool::execute(const job& j) {
+	batch& b = *j.b;
+	try {
+		(*b.task)(j.idx);
+	} catch (...) {
+		std::lock_guard<std::mutex> lk(b.mtx);
+		if (!b.error) b.error = std::current_exception();
+	}
+	// decrement under the lock, so the caller can't return and destroy the batch
+	// between our decrement and our notification
+	std::lock_guard<std::mutex> lk(b.mtx);
+	if (--b.remaining == 0) {
+		b.done.notify_all();
+	}
+}
+
+size_t thread_pool::self() const {
+	return t_pool == this ? t_index : m_queues.size();
+}
+
+}
@@ -0,0 +1,63 @@
+#include "observer.hpp"
+
+#include <algorithm>
+
+namespace ecs {
+
+observer::observer()
+	: m_reg(nullptr),
+	  m_ids(),
+	  m_slot(),
+	  m_connections() {
+}
+
+observer::~observer() {
+	disconnect();
+}
+
+const std::vector<entity_id>& observer::entities() const {
+	return m_ids;
+}
+
+size_t observer::size() const {
+	return m_ids.size();
+}
+
+bool observer::empty() const {
+	return m_ids.empty();
+}
+
+void observer::clear() {
+	for (entity_id id : m_ids) {
+		m_slot[entity_index(id)] = sparse_set::npos;
+	}
+	m_ids.clear();
+}
+
+void observer::disconnect() {
+	if (!m_connections.empty()) {
+		for (auto& [s, id] : m_connections) {
+			s->disconnect(id);
+		}
+		m_connections.clear();
+		auto& observers = m_reg->m_observers;
+		observers.erase(std::find(observers.begin(), observers.end(), this));
+	}
+	// the ids recorded are those of the old registry
+	m_reg = nullptr;
+	clear();
+}
+
+void observer::record(entity_id id) {
+	size_t idx = entity_index(id);
+	if (idx >= m_slot.size()) {
+		m_slot.resize(idx + 1, sparse_set::npos);
+	}
+	size_t& slot = m_slot[idx];
+	if (slot != sparse_set::npos && m_ids[slot] == id) return;
+	// a later generation of the index gets its own entry
+	slot = m_ids.size();
+	m_ids.push_back(id);
+}
+
+}
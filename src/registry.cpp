@@ -1,63 +1,613 @@
 #include "registry.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <functional>
+#include <sstream>
 #include <stdexcept>
+#include <streambuf>
+
+#include <internal/byte_reader.hpp>
 
 #include <entity.hpp>
+#include <observer.hpp>
 
 namespace ecs {
 
-registry::registry(size_t max_components)
-	: MAX_COMPONENTS(max_components) {
+registry::registry(size_t max_components, std::pmr::memory_resource* resource)
+	: MAX_COMPONENTS(max_components),
+	  m_resource(resource),
+	  m_entities(resource),
+	  m_free_ids(resource),
+	  m_free_slots(resource),
+	  m_next_index(0),
+	  m_tick(1),
+	  m_signatures(resource),
+	  m_workers(),
+	  m_workers_mtx(),
+	  m_groups(),
+	  m_queries(),
+	  m_signals(),
+	  m_observers(),
+	  m_compaction(),
+	  m_snapshot_types(),
+	  m_mappings() {
 }
 
 registry::~registry() {
-	for (auto& ent : m_entities) {
-		ent->destroy();
+	// the signals die with the registry, so the observers must not disconnect from them later
+	for (observer* obs : m_observers) {
+		obs->m_connections.clear();
+		obs->m_reg = nullptr;
 	}
-	m_entities.clear();
 }
 
 entity_t registry::create() {
-	m_entities.push_back(std::shared_ptr<entity>(new entity(*this)));
-	return m_entities.back();
+	entity_id id;
+	if (m_free_ids.empty()) {
+		if (m_next_index >= ENTITY_INDEX_MASK) {
+			throw std::out_of_range("Too many entities in the registry.");
+		}
+		id = make_entity_id(m_next_index++, 0);
+	} else {
+		id = take_free(m_free_ids.size() - 1);
+	}
+	m_entities.insert(id);
+	return entity(*this, id);
+}
+
+entity_t registry::create(entity_id id) {
+	size_t idx = entity_index(id);
+	if (idx >= ENTITY_INDEX_MASK) {
+		throw std::out_of_range("Too many entities in the registry.");
+	}
+	if (idx < m_next_index) {
+		if (idx >= m_free_slots.size() || m_free_slots[idx] == sparse_set::npos) {
+			throw std::runtime_error("An entity with the same index is in the registry.");
+		}
+		take_free(m_free_slots[idx]);
+	} else {
+		// the indices skipped over are free to use
+		m_free_ids.reserve(m_free_ids.size() + (idx - m_next_index));
+		for (size_t skipped = m_next_index; skipped < idx; ++skipped) {
+			push_free(make_entity_id(skipped, 0));
+		}
+		m_next_index = idx + 1;
+	}
+	m_entities.insert(id);
+	return entity(*this, id);
 }
 
 void registry::remove(entity_t e) {
-	e->destroy();
-	std::erase(m_entities, e);
+	if (e.m_reg != this || !valid(e.m_id)) return;
+	// remove all corresponding components
+	for (size_t cid = 0; cid < m_components.size(); ++cid) {
+		component_pool* pool = m_components[cid].get();
+		if (pool && pool->contains(e.m_id)) {
+			removing(cid, e.m_id);
+			pool->remove(e.m_id);
+		}
+	}
+	m_entities.remove(e.m_id);
+	push_free(make_entity_id(entity_index(e.m_id), entity_generation(e.m_id) + 1));
+}
+
+void registry::push_free(entity_id id) {
+	size_t idx = entity_index(id);
+	if (idx >= m_free_slots.size()) {
+		m_free_slots.resize(idx + 1, sparse_set::npos);
+	}
+	m_free_slots[idx] = m_free_ids.size();
+	m_free_ids.push_back(id);
+}
+
+entity_id registry::take_free(size_t slot) {
+	entity_id id	 = m_free_ids[slot];
+	entity_id last	 = m_free_ids.back();
+	m_free_ids[slot] = last;
+	m_free_ids.pop_back();
+	m_free_slots[entity_index(last)] = slot;
+	m_free_slots[entity_index(id)]	 = sparse_set::npos;
+	return id;
+}
+
+bool registry::owns(const entity_t& e) const {
+	return e.m_reg == this && valid(e.m_id);
+}
+
+bool registry::valid(entity_id id) const {
+	return m_entities.contains(id);
+}
+
+/// the first bytes of every snapshot
+static constexpr char SNAPSHOT_MAGIC[8] = { 'E', 'C', 'S', 'S', 'N', 'A', 'P', '\0' };
+/// bumped whenever the snapshot format changes
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+/// written as is, to tell snapshots of another byte order apart
+static constexpr uint32_t SNAPSHOT_ENDIAN = 0x01020304;
+
+/// write a value as its raw bytes
+template <typename T>
+static void write_raw(std::ostream& out, const T& value) {
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/// pad the stream with zeros up to the next multiple of align
+static void write_padding(std::ostream& out, size_t align) {
+	size_t pos = static_cast<size_t>(out.tellp());
+	for (size_t i = pos; i % align != 0; ++i) {
+		out.put('\0');
+	}
+}
+
+/// a read-only stream buffer over bytes in memory
+class memory_buf : public std::streambuf {
+public:
+	memory_buf(const char* data, size_t size) {
+		char* p = const_cast<char*>(data);
+		setg(p, p, p + size);
+	}
+};
+
+void registry::register_snapshot(size_t cid, snapshot_type type) {
+	for (const auto& [other, t] : m_snapshot_types) {
+		if (other != cid && t.name == type.name) {
+			throw std::runtime_error("Snapshot name " + type.name + " is taken by another component type.");
+		}
+	}
+	m_snapshot_types[cid] = std::move(type);
+}
+
+void registry::save(const std::string& path) const {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		throw std::runtime_error("Could not open " + path + ".");
+	}
+	std::vector<size_t> saved;
+	for (size_t cid = 0; cid < m_components.size(); ++cid) {
+		if (!m_components[cid] || m_components[cid]->count() == 0) continue;
+		if (!m_snapshot_types.contains(cid)) {
+			throw std::runtime_error("A component type was not registered for snapshots.");
+		}
+		saved.push_back(cid);
+	}
+	out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	write_raw(out, SNAPSHOT_VERSION);
+	write_raw(out, SNAPSHOT_ENDIAN);
+	write_raw<uint32_t>(out, sizeof(entity_id));
+	write_raw<uint32_t>(out, component_pool::PAGE_SZ);
+	write_raw<uint64_t>(out, m_next_index);
+	write_raw<uint64_t>(out, m_entities.size());
+	write_padding(out, alignof(entity_id));
+	out.write(reinterpret_cast<const char*>(m_entities.dense().data()), m_entities.size() * sizeof(entity_id));
+	write_raw<uint64_t>(out, m_free_ids.size());
+	write_padding(out, alignof(entity_id));
+	out.write(reinterpret_cast<const char*>(m_free_ids.data()), m_free_ids.size() * sizeof(entity_id));
+	write_raw<uint64_t>(out, saved.size());
+	for (size_t cid : saved) {
+		const component_pool& pool = *m_components[cid];
+		const snapshot_type& type  = m_snapshot_types.at(cid);
+		write_raw<uint64_t>(out, type.name.size());
+		out.write(type.name.data(), type.name.size());
+		write_raw<uint32_t>(out, type.raw);
+		write_raw<uint64_t>(out, pool.count());
+		write_padding(out, alignof(entity_id));
+		out.write(reinterpret_cast<const char*>(pool.entities().data()), pool.count() * sizeof(entity_id));
+		if (type.raw) {
+			// whole pages, so loading can use them in place
+			size_t pages = (pool.count() + component_pool::PAGE_SZ - 1) / component_pool::PAGE_SZ;
+			write_raw<uint64_t>(out, pool.page_bytes());
+			write_raw<uint64_t>(out, pool.page_align());
+			write_padding(out, pool.page_align());
+			for (size_t i = 0; i < pages; ++i) {
+				out.write(pool.page(i), pool.page_bytes());
+			}
+		} else {
+			std::ostringstream components(std::ios::binary);
+			type.save(pool, components);
+			std::string bytes = std::move(components).str();
+			write_raw<uint64_t>(out, bytes.size());
+			out.write(bytes.data(), bytes.size());
+		}
+	}
+	if (!out) {
+		throw std::runtime_error("Could not write " + path + ".");
+	}
+}
+
+void registry::load_mapped(const std::string& path) {
+	if (count() != 0 || !m_groups.empty()) {
+		throw std::runtime_error("Snapshots can only be loaded into an empty registry without groups.");
+	}
+	for (const auto& p : m_components) {
+		if (p && p->count() != 0) {
+			throw std::runtime_error("Snapshots can only be loaded into an empty registry without groups.");
+		}
+	}
+	auto file = std::make_unique<mapped_file>(path);
+	byte_reader in(file->data(), file->size());
+	if (std::memcmp(in.bytes(sizeof(SNAPSHOT_MAGIC)), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+		throw std::runtime_error(path + " is not a snapshot.");
+	}
+	if (in.read<uint32_t>() != SNAPSHOT_VERSION || in.read<uint32_t>() != SNAPSHOT_ENDIAN ||
+		in.read<uint32_t>() != sizeof(entity_id) || in.read<uint32_t>() != component_pool::PAGE_SZ) {
+		throw std::runtime_error(path + " was written by an incompatible version.");
+	}
+	size_t next_index		= in.read<uint64_t>();
+	size_t entity_count		= in.read<uint64_t>();
+	in.align(alignof(entity_id));
+	const char* entities	= in.bytes(entity_count, sizeof(entity_id));
+	size_t free_count		= in.read<uint64_t>();
+	in.align(alignof(entity_id));
+	const char* free_ids	= in.bytes(free_count, sizeof(entity_id));
+	size_t pool_count		= in.read<uint64_t>();
+
+	// every index handed out is either alive or free to reuse, exactly once
+	if (entity_count + free_count != next_index) {
+		throw std::runtime_error(path + " is corrupted.");
+	}
+	std::vector<bool> used(next_index);
+	auto use = [&](entity_id id) {
+		size_t idx = entity_index(id);
+		if (idx >= next_index || used[idx]) {
+			throw std::runtime_error(path + " is corrupted.");
+		}
+		used[idx] = true;
+	};
+	// the entity table, to check the entities of each pool against, and which pool last listed each entity
+	sparse_set table(m_resource);
+	table.reserve(entity_count);
+	for (size_t i = 0; i < entity_count; ++i) {
+		use(reinterpret_cast<const entity_id*>(entities)[i]);
+		table.insert(reinterpret_cast<const entity_id*>(entities)[i]);
+	}
+	for (size_t i = 0; i < free_count; ++i) {
+		use(reinterpret_cast<const entity_id*>(free_ids)[i]);
+	}
+	std::vector<size_t> listed(entity_count, sparse_set::npos);
+
+	/// a pool of the snapshot, checked against its registered type
+	struct saved_pool {
+		size_t cid;
+		const snapshot_type* type;
+		size_t count;
+		const entity_id* ents;
+		/// the first page if raw, else the bytes the hooks wrote
+		char* data;
+		size_t bytes;
+	};
+	std::vector<saved_pool> pools;
+	// check everything before touching the registry
+	for (size_t i = 0; i < pool_count; ++i) {
+		size_t name_len = in.read<uint64_t>();
+		std::string name(in.bytes(name_len), name_len);
+		auto it = std::find_if(m_snapshot_types.begin(), m_snapshot_types.end(), [&name](const auto& t) {
+			return t.second.name == name;
+		});
+		if (it == m_snapshot_types.end()) {
+			throw std::runtime_error("Component type " + name + " of the snapshot is not registered.");
+		}
+		saved_pool p{ it->first, &it->second, 0, nullptr, nullptr, 0 };
+		if (std::any_of(pools.begin(), pools.end(), [&p](const saved_pool& other) { return other.cid == p.cid; })) {
+			throw std::runtime_error("Component type " + name + " is saved twice in the snapshot.");
+		}
+		bool raw = in.read<uint32_t>() != 0;
+		if (raw != p.type->raw) {
+			throw std::runtime_error("Component type " + name + " was saved differently than it is registered.");
+		}
+		p.count = in.read<uint64_t>();
+		in.align(alignof(entity_id));
+		p.ents	= reinterpret_cast<const entity_id*>(in.bytes(p.count, sizeof(entity_id)));
+		if (p.count > MAX_COMPONENTS) {
+			throw std::out_of_range("Component type " + name + " has too many components in the snapshot.");
+		}
+		for (size_t j = 0; j < p.count; ++j) {
+			size_t pos = table.find(p.ents[j]);
+			if (pos == sparse_set::npos || listed[pos] == i) {
+				throw std::runtime_error("Component type " + name + " lists an entity missing from the snapshot, or twice.");
+			}
+			listed[pos] = i;
+		}
+		if (raw) {
+			// compared with the layout the pool will have, so a snapshot that fails constructs no pool
+			size_t page_bytes = in.read<uint64_t>();
+			size_t page_align = in.read<uint64_t>();
+			if (page_bytes != p.type->page_bytes || page_align != p.type->page_align) {
+				throw std::runtime_error("Component type " + name + " has changed layout since the snapshot.");
+			}
+			in.align(page_align);
+			size_t pages = (p.count + component_pool::PAGE_SZ - 1) / component_pool::PAGE_SZ;
+			p.data		 = const_cast<char*>(in.bytes(pages, page_bytes));
+			if (reinterpret_cast<std::uintptr_t>(p.data) % page_align != 0) {
+				throw std::runtime_error("Component type " + name + " is too aligned to be mapped.");
+			}
+		} else {
+			p.bytes = in.read<uint64_t>();
+			p.data	= const_cast<char*>(in.bytes(p.bytes));
+		}
+		pools.push_back(p);
+	}
+
+	m_entities.reserve(entity_count);
+	for (size_t i = 0; i < entity_count; ++i) {
+		m_entities.insert(reinterpret_cast<const entity_id*>(entities)[i]);
+	}
+	m_free_ids.reserve(free_count);
+	for (size_t i = 0; i < free_count; ++i) {
+		push_free(reinterpret_cast<const entity_id*>(free_ids)[i]);
+	}
+	m_next_index = next_index;
+	for (const saved_pool& p : pools) {
+		if (p.type->raw) {
+			std::vector<char*> pages;
+			size_t page_bytes = p.type->assure(*this).page_bytes();
+			for (size_t i = 0; i * component_pool::PAGE_SZ < p.count; ++i) {
+				pages.push_back(p.data + i * page_bytes);
+			}
+			p.type->assure(*this).adopt(p.ents, p.count, pages);
+			bool watched = (p.cid < m_signals.size() && m_signals[p.cid]) ||
+						   std::any_of(m_queries.begin(), m_queries.end(), [&p](const auto& q) { return q->watches(p.cid); });
+			if (watched) {
+				for (size_t i = 0; i < p.count; ++i) {
+					added(p.cid, p.ents[i]);
+				}
+			} else {
+				// nothing listens, only the signatures need to know
+				for (size_t i = 0; i < p.count; ++i) {
+					m_signatures.set(entity_index(p.ents[i]), p.cid);
+				}
+			}
+		} else {
+			memory_buf buf(p.data, p.bytes);
+			std::istream components(&buf);
+			p.type->load(*this, p.ents, p.count, components);
+		}
+	}
+	m_mappings.push_back(std::move(file));
+}
+
+size_t registry::compact() {
+	size_t released = 0;
+	for (size_t cid = 0; cid < m_components.size(); ++cid) {
+		if (m_components[cid]) released += compact_pool(cid);
+	}
+	m_compaction = compaction();
+	return released + m_entities.shrink_to_fit();
 }
 
-void registry::remove(std::type_index ti, size_t idx) {
-	if (m_components.contains(ti)) {
-		m_components.at(ti).remove(idx);
+size_t registry::compact(size_t max_moves) {
+	size_t released = 0;
+	compaction& c	= m_compaction;
+	// stop after one sweep over the pools, even if the budget is not spent
+	for (size_t visited = 0; max_moves > 0 && visited <= m_components.size();) {
+		if (c.cid >= m_components.size()) {
+			c = compaction();
+			released += m_entities.shrink_to_fit();
+			break;
+		}
+		component_pool* p = m_components[c.cid].get();
+		if (!p || grouped(c.cid)) {
+			// a pool owned by a group keeps its order and is only shrunk, and the cursor moves on to the next pool
+			if (p) released += p->shrink_to_fit();
+			c = compaction{ c.cid + 1 };
+			visited++;
+			continue;
+		}
+		// the positions already arranged must still hold what the cursor put there
+		bool stale = c.order.size() != p->count() || (c.pos > 0 && p->entities()[c.pos - 1] != c.order[c.pos - 1]);
+		if (stale || (c.order.empty() && c.pos == 0)) {
+			c.order = sorted_entities(*p);
+			c.pos	= 0;
+		}
+		size_t from = c.pos;
+		bool fresh	= p->arrange(c.order, c.pos, max_moves);
+		max_moves -= c.pos - from;
+		if (!fresh) {
+			// entities were added or removed since the pool was started
+			c.order = sorted_entities(*p);
+			c.pos	= 0;
+			continue;
+		}
+		if (c.pos >= c.order.size()) {
+			released += p->shrink_to_fit();
+			c = compaction{ c.cid + 1 };
+			visited++;
+		}
 	}
+	return released;
+}
+
+size_t registry::compact_pool(size_t cid) {
+	component_pool& p = *m_components[cid];
+	if (!grouped(cid)) {
+		size_t pos = 0;
+		p.arrange(sorted_entities(p), pos, p.count());
+	}
+	return p.shrink_to_fit();
+}
+
+bool registry::grouped(size_t cid) const {
+	return std::any_of(m_groups.begin(), m_groups.end(), [cid](const auto& g) { return g->owns(cid); });
+}
+
+std::vector<entity_id> registry::sorted_entities(const component_pool& pool) {
+	std::vector<entity_id> order(pool.entities().begin(), pool.entities().end());
+	std::sort(order.begin(), order.end(), [](entity_id a, entity_id b) {
+		return entity_index(a) < entity_index(b);
+	});
+	return order;
+}
+
+group_storage& registry::assure_group(std::vector<size_t> owned, std::vector<component_pool*> pools) {
+	std::vector<size_t> sorted = owned;
+	std::sort(sorted.begin(), sorted.end());
+	if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+		throw std::runtime_error("A group can't own the same component twice.");
+	}
+	for (auto& g : m_groups) {
+		std::vector<size_t> theirs = g->owned();
+		std::sort(theirs.begin(), theirs.end());
+		if (theirs == sorted) {
+			return *g;
+		}
+		for (size_t cid : sorted) {
+			if (g->owns(cid)) {
+				throw std::runtime_error("Component pool is already owned by another group.");
+			}
+		}
+	}
+	m_groups.emplace_back(new group_storage(std::move(owned), std::move(pools)));
+	return *m_groups.back();
+}
+
+query_storage& registry::assure_query(component_mask required, component_mask excluded, std::vector<const component_pool*> pools) {
+	for (auto& q : m_queries) {
+		if (q->caches(required, excluded)) {
+			return *q;
+		}
+	}
+	m_queries.emplace_back(new query_storage(std::move(required), std::move(excluded), m_signatures, m_resource));
+	query_storage& q = *m_queries.back();
+	if (std::find(pools.begin(), pools.end(), nullptr) != pools.end()) {
+		// no entity has every required component yet
+		return q;
+	}
+	// walk the smallest pool for the entities already matching
+	const component_pool* smallest = *std::min_element(pools.begin(), pools.end(), [](const component_pool* a, const component_pool* b) {
+		return a->count() < b->count();
+	});
+	for (entity_id id : smallest->entities()) {
+		q.update(id);
+	}
+	return q;
+}
+
+void registry::added(size_t cid, entity_id id) {
+	m_signatures.set(entity_index(id), cid);
+	for (auto& g : m_groups) {
+		if (g->owns(cid)) {
+			g->added(id);
+		}
+	}
+	for (auto& q : m_queries) {
+		if (q->watches(cid)) {
+			q->update(id);
+		}
+	}
+	if (cid < m_signals.size() && m_signals[cid]) {
+		m_signals[cid]->construct.emit(id);
+	}
+}
+
+void registry::removing(size_t cid, entity_id id) {
+	// listeners still see the component
+	if (cid < m_signals.size() && m_signals[cid]) {
+		m_signals[cid]->destroy.emit(id);
+	}
+	for (auto& g : m_groups) {
+		if (g->owns(cid)) {
+			g->removing(id);
+		}
+	}
+	m_signatures.reset(entity_index(id), cid);
+	for (auto& q : m_queries) {
+		if (q->watches(cid)) {
+			q->update(id);
+		}
+	}
+}
+
+void registry::updated(size_t cid, entity_id id) {
+	if (cid < m_signals.size() && m_signals[cid]) {
+		m_signals[cid]->update.emit(id);
+	}
+}
+
+registry::component_signals& registry::assure_signals(size_t cid) {
+	if (cid >= m_signals.size()) {
+		m_signals.resize(cid + 1);
+	}
+	if (!m_signals[cid]) {
+		m_signals[cid] = std::make_unique<component_signals>();
+	}
+	return *m_signals[cid];
+}
+
+bool registry::has(std::type_index ti, entity_id id) const {
+	const component_pool* p = find_pool(ti);
+	return p && p->contains(id);
 }
 
 size_t registry::count() const {
 	return m_entities.size();
 }
 
-std::list<entity_t>& registry::entities() {
-	return m_entities;
+const std::pmr::vector<entity_id>& registry::entities() const {
+	return m_entities.dense();
+}
+
+std::pmr::memory_resource* registry::resource() const {
+	return m_resource;
 }
 
-const std::list<entity_t>& registry::entities() const {
-	return m_entities;
+uint64_t registry::tick() const {
+	return m_tick;
+}
+
+uint64_t registry::advance_tick() {
+	return m_tick++;
 }
 
 component_pool& registry::pool(std::type_index ti) {
-	if (!m_components.contains(ti)) {
+	component_pool* p = find_pool(ti);
+	if (!p) {
 		throw std::out_of_range("Type not in component pool.");
 	}
-	return m_components.at(ti);
+	return *p;
 }
 
 const component_pool& registry::pool(std::type_index ti) const {
-	if (!m_components.contains(ti)) {
+	const component_pool* p = find_pool(ti);
+	if (!p) {
 		throw std::out_of_range("Type not in component pool.");
 	}
-	return m_components.at(ti);
+	return *p;
+}
+
+component_pool* registry::find_pool(std::type_index ti) {
+	auto it = m_component_ids.find(ti);
+	return it == m_component_ids.end() ? nullptr : m_components[it->second].get();
+}
+
+const component_pool* registry::find_pool(std::type_index ti) const {
+	auto it = m_component_ids.find(ti);
+	return it == m_component_ids.end() ? nullptr : m_components[it->second].get();
+}
+
+thread_pool& registry::workers() const {
+	std::lock_guard<std::mutex> lk(m_workers_mtx);
+	if (!m_workers) {
+		m_workers = std::make_shared<thread_pool>();
+	}
+	return *m_workers;
+}
+
+void registry::use_workers(std::shared_ptr<thread_pool> pool) {
+	std::lock_guard<std::mutex> lk(m_workers_mtx);
+	m_workers = pool;
+}
+
+entity_t registry::at(entity_id id) const {
+	if (!valid(id)) {
+		throw std::out_of_range("No entity with that id.");
+	}
+	return handle(id);
+}
+
+entity_t registry::handle(entity_id id) const {
+	return entity(const_cast<registry&>(*this), id);
 }
 
 std::function<bool(entity_t)> registry::entity_has_components(std::vector<std::type_index> ts) {
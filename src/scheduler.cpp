@@ -0,0 +1,68 @@
+#include "scheduler.hpp"
+
+#include <stdexcept>
+
+namespace ecs {
+
+scheduler::scheduler(registry& r)
+	: m_reg(r),
+	  m_systems(),
+	  m_stages() {
+}
+
+void scheduler::run() {
+	for (auto& stage : m_stages) {
+		if (stage.size() == 1) {
+			m_systems[stage.front()].run(m_reg);
+			continue;
+		}
+		m_reg.workers().run(stage.size(), [this, &stage](size_t i) {
+			m_systems[stage[i]].run(m_reg);
+		});
+	}
+}
+
+size_t scheduler::size() const {
+	return m_systems.size();
+}
+
+size_t scheduler::stages() const {
+	return m_stages.size();
+}
+
+size_t scheduler::stage(size_t system) const {
+	if (system >= m_systems.size()) {
+		throw std::out_of_range("No system at that index.");
+	}
+	return m_systems[system].stage;
+}
+
+void scheduler::insert(std::function<void(registry&)> run, std::vector<size_t> read, std::vector<size_t> write) {
+	system s{ std::move(run), std::move(read), std::move(write), 0 };
+	// run after every earlier system we conflict with, so their order is kept
+	for (const system& other : m_systems) {
+		if (conflicts(s, other)) {
+			s.stage = std::max(s.stage, other.stage + 1);
+		}
+	}
+	if (s.stage >= m_stages.size()) {
+		m_stages.resize(s.stage + 1);
+	}
+	m_stages[s.stage].push_back(m_systems.size());
+	m_systems.push_back(std::move(s));
+}
+
+bool scheduler::conflicts(const system& a, const system& b) {
+	auto overlap = [](const std::vector<size_t>& x, const std::vector<size_t>& y) {
+		auto i = x.begin();
+		auto j = y.begin();
+		while (i != x.end() && j != y.end()) {
+			if (*i == *j) return true;
+			*i < *j ? ++i : ++j;
+		}
+		return false;
+	};
+	return overlap(a.write, b.write) || overlap(a.write, b.read) || overlap(a.read, b.write);
+}
+
+}
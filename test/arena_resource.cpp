@@ -0,0 +1,66 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <ecs.hpp>
+
+struct alignas(128) wide {
+	float lanes[32];
+};
+
+TEST_CASE("Arena resources work", "[arena_resource]") {
+	using namespace ecs;
+	GIVEN("A registry allocating from an arena") {
+		arena_resource arena;
+		{
+			registry reg(component_pool::unlimited, &arena);
+			REQUIRE(reg.resource() == &arena);
+			std::vector<entity_t> ents;
+			reg.create_many(3000, std::back_inserter(ents));
+			for (auto& e : ents) {
+				e->add<wide>();
+			}
+			THEN("Its memory comes from the arena") {
+				REQUIRE(arena.allocated() >= 3000 * sizeof(wide));
+				REQUIRE(arena.reserved() >= arena.allocated());
+			}
+			THEN("Components keep their alignment") {
+				for (auto& e : ents) {
+					REQUIRE(reinterpret_cast<std::uintptr_t>(&e->get<wide>()) % alignof(wide) == 0);
+				}
+			}
+			WHEN("Pools shrink and grow again") {
+				for (size_t i = 0; i < 2000; ++i) {
+					ents[i]->remove<wide>();
+				}
+				reg.compact();
+				size_t reserved = arena.reserved();
+				for (size_t i = 0; i < 2000; ++i) {
+					ents[i]->add<wide>();
+				}
+				THEN("The freed pages are reused") {
+					REQUIRE(arena.reserved() == reserved);
+				}
+			}
+		}
+		THEN("Everything is handed back once the registry is gone") {
+			REQUIRE(arena.allocated() == 0);
+		}
+	}
+	GIVEN("An arena used directly") {
+		arena_resource arena(1, false);
+		void* small = arena.allocate(24, 8);
+		void* large = arena.allocate(arena_resource::HUGE_PAGE_SZ * 2, 64);
+		THEN("Blocks are aligned, and large ones get their own chunk") {
+			REQUIRE(reinterpret_cast<std::uintptr_t>(small) % 8 == 0);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(large) % 64 == 0);
+			REQUIRE(arena.reserved() == arena_resource::HUGE_PAGE_SZ * 3);
+		}
+		arena.deallocate(small, 24, 8);
+		arena.deallocate(large, arena_resource::HUGE_PAGE_SZ * 2, 64);
+		THEN("Freed blocks are reused") {
+			REQUIRE(arena.allocate(24, 8) == small);
+		}
+	}
+}
@@ -0,0 +1,139 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <ecs.hpp>
+
+struct tracked_pos {
+	float x;
+	float y;
+};
+
+struct tracked_vel {
+	float x;
+	float y;
+};
+
+TEST_CASE("Registries track changes to components", "[change_tracking]") {
+	using namespace ecs;
+	GIVEN("A registry tracking one type of component") {
+		registry reg;
+		reg.track<tracked_pos>();
+		std::vector<entity_t> ents;
+		reg.create_many(3000, std::back_inserter(ents));
+		for (auto& e : ents) {
+			e->add<tracked_pos>(0.f, 0.f);
+			e->add<tracked_vel>(1.f, 1.f);
+		}
+		uint64_t since = reg.advance_tick();
+		const registry& cr = reg;
+
+		/// the entities of the view, walked read-only
+		auto seen = [](const auto& v) {
+			std::vector<entity_id> ids;
+			v.each([&ids](entity_t e, const auto&...) {
+				ids.push_back(e.id());
+			});
+			return ids;
+		};
+
+		THEN("Everything was added before the tick") {
+			REQUIRE(seen(cr.view<tracked_pos>().added<tracked_pos>(since - 1)).size() == 3000);
+			REQUIRE(seen(cr.view<tracked_pos>().added<tracked_pos>(since)).empty());
+			REQUIRE(seen(cr.view<tracked_pos>().changed<tracked_pos>(since)).empty());
+		}
+		WHEN("A few components are patched or handed out mutably") {
+			ents[5]->patch<tracked_pos>([](tracked_pos& p) {
+				p.x = 1.f;
+			});
+			ents[2500]->get<tracked_pos>().y = 2.f;
+			THEN("Only those count as changed") {
+				std::vector<entity_id> ids = seen(cr.view<tracked_pos, tracked_vel>().changed<tracked_pos>(since));
+				REQUIRE(ids == std::vector<entity_id>{ ents[5].id(), ents[2500].id() });
+				REQUIRE(seen(cr.view<tracked_pos>().added<tracked_pos>(since)).empty());
+			}
+			THEN("Later ticks don't see them") {
+				uint64_t later = reg.advance_tick();
+				REQUIRE(seen(cr.view<tracked_pos>().changed<tracked_pos>(later)).empty());
+			}
+		}
+		WHEN("Components are added, removed and moved around") {
+			entity_t fresh = reg.create();
+			fresh->add<tracked_pos>(3.f, 3.f);
+			ents[10]->get<tracked_pos>();
+			ents[0]->remove<tracked_pos>();
+			reg.compact();
+			THEN("The stamps follow the components") {
+				std::vector<entity_id> added = seen(cr.view<tracked_pos>().added<tracked_pos>(since));
+				REQUIRE(added == std::vector<entity_id>{ fresh.id() });
+				std::vector<entity_id> changed = seen(cr.view<tracked_pos>().changed<tracked_pos>(since));
+				std::sort(changed.begin(), changed.end());
+				REQUIRE(changed == std::vector<entity_id>{ ents[10].id(), fresh.id() });
+			}
+		}
+		WHEN("A non-const view walks the components") {
+			reg.view<tracked_pos>().each([](tracked_pos&) {});
+			THEN("They all count as changed") {
+				REQUIRE(seen(cr.view<tracked_pos>().changed<tracked_pos>(since)).size() == 3000);
+			}
+		}
+		WHEN("Scheduled systems only read the tracked components") {
+			scheduler s(reg);
+			s.add<reads<tracked_pos>>([](const tracked_pos&) {});
+			s.add<reads<tracked_pos>, writes<tracked_vel>>([](const tracked_pos& p, tracked_vel& v) {
+				v.x = p.x;
+			});
+			s.run();
+			THEN("None of them count as changed") {
+				REQUIRE(s.stages() == 1);
+				REQUIRE(seen(cr.view<tracked_pos>().changed<tracked_pos>(since)).empty());
+			}
+		}
+		WHEN("A scheduled system writes the tracked components") {
+			scheduler s(reg);
+			s.add<writes<tracked_pos>, reads<tracked_vel>>([](tracked_pos& p, const tracked_vel& v) {
+				p.x += v.x;
+			});
+			s.run();
+			THEN("They all count as changed") {
+				REQUIRE(seen(cr.view<tracked_pos>().changed<tracked_pos>(since)).size() == 3000);
+			}
+		}
+		WHEN("A few components change between passes over chunks") {
+			ents[1]->get<tracked_pos>();
+			ents[2999]->get<tracked_pos>();
+			size_t walked = 0;
+			cr.view<tracked_pos, tracked_vel>().changed<tracked_pos>(since).each_chunk([&walked](std::span<const tracked_pos> p, std::span<const tracked_vel>) {
+				walked += p.size();
+			});
+			size_t par_walked = 0;
+			std::mutex mtx;
+			cr.view<tracked_pos>().changed<tracked_pos>(since).par_each([&](const tracked_pos&) {
+				std::lock_guard lock(mtx);
+				par_walked++;
+			}, par_options{ 100 });
+			THEN("Only they are walked") {
+				REQUIRE(walked == 2);
+				REQUIRE(par_walked == 2);
+			}
+		}
+		WHEN("Filtering by an untracked type") {
+			THEN("The view throws") {
+				REQUIRE_THROWS_AS(seen(cr.view<tracked_pos, tracked_vel>().changed<tracked_vel>(since)), std::runtime_error);
+			}
+		}
+		WHEN("Iterating a filtered view") {
+			auto v = reg.view<tracked_pos>().changed<tracked_pos>(since);
+			THEN("It throws") {
+				REQUIRE_THROWS_AS(v.begin(), std::runtime_error);
+			}
+		}
+	}
+}
@@ -0,0 +1,163 @@
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	int x;
+	int y;
+};
+
+struct health {
+	int hp;
+};
+
+struct name {
+	std::string value;
+};
+
+/// a component refusing an empty name
+struct picky {
+	std::string value;
+	picky(const char* v)
+		: value(v) {
+		if (value.empty()) throw std::invalid_argument("Empty name.");
+	}
+};
+}
+
+TEST_CASE("Command buffers work.", "[command_buffer]") {
+	using namespace ecs;
+	GIVEN("A registry and a command buffer") {
+		registry reg;
+		command_buffer cmd;
+		auto e1 = reg.create();
+		auto e2 = reg.create();
+		e1->add<position>(1, 1);
+		e2->add<position>(2, 2);
+		e2->add<health>(10);
+		WHEN("Commands are recorded") {
+			auto p = cmd.create();
+			cmd.add<position>(p, 5, 6);
+			cmd.add<name>(p, "spawned");
+			cmd.add<health>(e1, 3);
+			cmd.replace<position>(e1, 7, 7);
+			cmd.remove<health>(e2);
+			THEN("Nothing changes until they are flushed") {
+				REQUIRE(reg.count() == 2);
+				REQUIRE_FALSE(e1->has<health>());
+				REQUIRE(e1->get<position>().x == 1);
+				REQUIRE_FALSE(cmd.empty());
+			}
+			THEN("Flushing plays them back") {
+				std::vector<entity_t> created = cmd.flush(reg);
+				REQUIRE(cmd.empty());
+				REQUIRE(created.size() == 1);
+				REQUIRE(reg.count() == 3);
+				REQUIRE(created[0]->get<position>().x == 5);
+				REQUIRE(created[0]->get<name>().value == "spawned");
+				REQUIRE(e1->get<health>().hp == 3);
+				REQUIRE(e1->get<position>().x == 7);
+				REQUIRE_FALSE(e2->has<health>());
+			}
+		}
+		WHEN("Constructing a recorded component throws") {
+			cmd.add<picky>(e1, "kept");
+			REQUIRE_THROWS_AS(cmd.add<picky>(e2, ""), std::invalid_argument);
+			THEN("Only the commands recorded before it are played back") {
+				cmd.flush(reg);
+				REQUIRE(cmd.empty());
+				REQUIRE(e1->get<picky>().value == "kept");
+				REQUIRE_FALSE(e2->has<picky>());
+			}
+		}
+		WHEN("Entities are destroyed from within a view") {
+			reg.view<position>().each([&cmd](entity_t e, position& p) {
+				if (p.x == 2) cmd.destroy(e);
+			});
+			cmd.flush(reg);
+			THEN("They are gone after the flush") {
+				REQUIRE(reg.count() == 1);
+				REQUIRE_FALSE(e2.alive());
+				REQUIRE(e1.alive());
+			}
+		}
+		WHEN("Commands target an entity destroyed in the meantime") {
+			cmd.add<health>(e1, 1);
+			cmd.replace<health>(e1, 2);
+			cmd.destroy(e1);
+			cmd.remove<health>(e1);
+			reg.remove(e1);
+			THEN("They do nothing") {
+				REQUIRE_NOTHROW(cmd.flush(reg));
+				REQUIRE(reg.count() == 1);
+			}
+		}
+		WHEN("Commands on the same component are recorded") {
+			cmd.replace<health>(e1, 4);
+			cmd.add<health>(e1, 5);
+			cmd.add<health>(e1, 6);
+			cmd.remove<health>(e2);
+			cmd.add<health>(e2, 7);
+			cmd.flush(reg);
+			THEN("They apply in order") {
+				REQUIRE(e1->get<health>().hp == 6);
+				REQUIRE(e2->get<health>().hp == 7);
+			}
+		}
+		THEN("Placeholders of another buffer are rejected") {
+			command_buffer other;
+			auto p = other.create();
+			REQUIRE_THROWS_AS(cmd.add<health>(p, 1), std::runtime_error);
+		}
+		THEN("Unflushed payloads are destroyed with the buffer") {
+			auto shared = std::make_shared<int>(0);
+			{
+				command_buffer scratch;
+				struct holder {
+					std::shared_ptr<int> p;
+				};
+				scratch.add<holder>(e1, shared);
+				REQUIRE(shared.use_count() == 2);
+			}
+			REQUIRE(shared.use_count() == 1);
+		}
+	}
+	GIVEN("A command queue over a registry with many entities") {
+		registry reg;
+		reg.use_workers(std::make_shared<thread_pool>(4));
+		for (int i = 0; i < 10000; ++i) {
+			auto e = reg.create();
+			e->add<health>(i % 2);
+		}
+		command_queue queue(reg);
+		WHEN("A parallel system spawns and destroys entities") {
+			reg.view<health>().par_each([&queue](entity_t e, health& h) {
+				command_buffer& cmd = queue.local();
+				if (h.hp == 0) {
+					cmd.destroy(e);
+					auto child = cmd.create();
+					cmd.add<position>(child, 1, 2);
+				}
+			}, { .grain = 100 });
+			queue.flush();
+			THEN("Every change is played back") {
+				REQUIRE(reg.count() == 10000);
+				size_t n = 0;
+				reg.view<position>().each([&n](position& p) {
+					REQUIRE(p.y == 2);
+					n++;
+				});
+				REQUIRE(n == 5000);
+				reg.view<health>().each([](health& h) {
+					REQUIRE(h.hp == 1);
+				});
+			}
+		}
+	}
+}
@@ -1,39 +1,96 @@
 #include <catch2/catch.hpp>
 
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <internal/component_pool.hpp>
 
+/// counts how many of it are alive
+struct tracked {
+	static inline int alive = 0;
+	std::string name;
+	tracked(std::string name)
+		: name(std::move(name)) {
+		alive++;
+	}
+	tracked(const tracked& other)
+		: name(other.name) {
+		alive++;
+	}
+	tracked(tracked&& other) noexcept
+		: name(std::move(other.name)) {
+		alive++;
+	}
+	~tracked() {
+		alive--;
+	}
+};
+
+/// counts how many of it are alive, refusing an empty name and copies of "nocopy"
+struct fragile {
+	static inline int alive = 0;
+	std::string name;
+	fragile(std::string name)
+		: name(std::move(name)) {
+		if (this->name.empty()) throw std::invalid_argument("Empty name.");
+		alive++;
+	}
+	fragile(const fragile& other)
+		: name(other.name) {
+		if (name == "nocopy") throw std::runtime_error("Can't copy.");
+		alive++;
+	}
+	fragile(fragile&& other) noexcept
+		: name(std::move(other.name)) {
+		alive++;
+	}
+	~fragile() {
+		alive--;
+	}
+};
+
 TEST_CASE("Component pools work", "[component_pool]") {
 	using namespace ecs;
 	GIVEN("A component pool") {
 		component_pool cp(2, sizeof(double));
 		REQUIRE(cp.count() == 0);
 		WHEN("Components are added") {
-			size_t i = cp.add<double>(5.0);
-			size_t j = cp.add<double>(3.0);
-			REQUIRE(i == 0);
-			REQUIRE(j == 1);
+			cp.add<double>(7, 5.0);
+			cp.add<double>(3, 3.0);
 			THEN("The size updates accordingly") {
 				REQUIRE(cp.count() == 2);
 			}
 			THEN("They can be retrieved") {
-				REQUIRE(*cp.get<double>(i) == 5.0);
-				REQUIRE(*cp.get<double>(j) == 3.0);
+				REQUIRE(*cp.get<double>(7) == 5.0);
+				REQUIRE(*cp.get<double>(3) == 3.0);
+			}
+			THEN("They are packed in insertion order") {
+				REQUIRE(cp.index(7) == 0);
+				REQUIRE(cp.index(3) == 1);
+				REQUIRE(*cp.at<double>(0) == 5.0);
+				REQUIRE(*cp.at<double>(1) == 3.0);
 			}
 			THEN("They can be removed") {
-				cp.remove(i);
-				REQUIRE_THROWS(cp.get<double>(i));
+				cp.remove(7);
+				REQUIRE_THROWS(cp.get<double>(7));
 				REQUIRE(cp.count() == 1);
-				cp.remove(j);
-				REQUIRE_THROWS(cp.get<double>(j));
+				cp.remove(3);
+				REQUIRE_THROWS(cp.get<double>(3));
 				REQUIRE(cp.count() == 0);
-				REQUIRE_THROWS(cp.remove(i));
+				REQUIRE_THROWS(cp.remove(7));
+			}
+			THEN("An entity cannot hold two components of the pool") {
+				REQUIRE_THROWS(cp.add<double>(7, 1.0));
 			}
 		}
 		WHEN("Too many components are added") {
-			cp.add<double>(5.0);
-			cp.add<double>(3.0);
+			cp.add<double>(0, 5.0);
+			cp.add<double>(1, 3.0);
 			THEN("It throws") {
-				REQUIRE_THROWS(cp.add<double>(8.0));
+				REQUIRE_THROWS(cp.add<double>(2, 8.0));
 			}
 		}
 		WHEN("Nonexistent components are removed") {
@@ -42,14 +99,185 @@ TEST_CASE("Component pools work", "[component_pool]") {
 			}
 		}
 		WHEN("A hole is created") {
-			size_t i = cp.add<double>(5.0);
-			size_t j = cp.add<double>(3.0);
-			REQUIRE(i == 0);
-			REQUIRE(j == 1);
-			cp.remove(i);
-			THEN("A new added component fills that hole") {
-				REQUIRE(cp.add<double>(2.8) == 0);
+			cp.add<double>(0, 5.0);
+			cp.add<double>(1, 3.0);
+			cp.remove(0);
+			THEN("The last component is moved into it") {
+				REQUIRE(cp.index(1) == 0);
+				REQUIRE(*cp.at<double>(0) == 3.0);
+				REQUIRE(cp.entities()[0] == 1);
+			}
+			THEN("A new added component is appended after it") {
+				cp.add<double>(4, 2.8);
+				REQUIRE(cp.index(4) == 1);
+				REQUIRE(*cp.get<double>(1) == 3.0);
+			}
+		}
+		WHEN("A component is cloned") {
+			cp.add<double>(0, 5.0);
+			cp.clone(0, 9);
+			THEN("The new entity has a copy") {
+				REQUIRE(*cp.get<double>(9) == 5.0);
+				REQUIRE(cp.count() == 2);
 			}
 		}
 	}
+	GIVEN("A full component pool") {
+		const size_t cap = component_pool::PAGE_SZ * 2;
+		component_pool cp(cap, sizeof(size_t));
+		for (size_t i = 0; i < cap; ++i) {
+			cp.add<size_t>(i, i);
+		}
+		WHEN("Components are removed and added over and over at full capacity") {
+			std::mt19937 rng(1337);
+			std::vector<entity_id> free;
+			entity_id next = cap;
+			for (int i = 0; i < 20000; ++i) {
+				if (free.empty() || (cp.count() == cap) || rng() % 2) {
+					entity_id victim = cp.entities()[rng() % cp.count()];
+					cp.remove(victim);
+					free.push_back(victim);
+				} else {
+					cp.add<size_t>(next, next);
+					next++;
+					free.pop_back();
+				}
+			}
+			THEN("The pool never grows past its cap and every component is intact") {
+				REQUIRE(cp.capacity() == cap);
+				REQUIRE(cp.count() <= cap);
+				for (size_t i = 0; i < cp.count(); ++i) {
+					REQUIRE(*cp.at<size_t>(i) == cp.entities()[i]);
+					REQUIRE(cp.index(cp.entities()[i]) == i);
+				}
+			}
+		}
+	}
+	GIVEN("A component pool without a cap") {
+		component_pool cp(component_pool::unlimited, sizeof(int));
+		REQUIRE(cp.capacity() == 0);
+		WHEN("More components than fit in a page are added") {
+			int* first = cp.add<int>(0, 42);
+			for (size_t i = 1; i < component_pool::PAGE_SZ * 3; ++i) {
+				cp.add<int>(i, (int)i);
+			}
+			THEN("The pool grows by pages") {
+				REQUIRE(cp.count() == component_pool::PAGE_SZ * 3);
+				REQUIRE(cp.capacity() == component_pool::PAGE_SZ * 3);
+			}
+			THEN("Components do not move") {
+				REQUIRE(cp.get<int>(0) == first);
+				REQUIRE(*first == 42);
+				REQUIRE(*cp.get<int>(component_pool::PAGE_SZ * 2 + 5) == (int)component_pool::PAGE_SZ * 2 + 5);
+			}
+		}
+		WHEN("Components on different pages are swapped") {
+			for (size_t i = 0; i < component_pool::PAGE_SZ + 1; ++i) {
+				cp.add<int>(i, (int)i);
+			}
+			cp.swap(1, component_pool::PAGE_SZ);
+			THEN("Their entities are swapped along with them") {
+				REQUIRE(cp.entities()[1] == component_pool::PAGE_SZ);
+				REQUIRE(cp.index(1) == component_pool::PAGE_SZ);
+				REQUIRE(*cp.at<int>(1) == (int)component_pool::PAGE_SZ);
+				REQUIRE(*cp.get<int>(1) == 1);
+				REQUIRE(*cp.get<int>(component_pool::PAGE_SZ) == (int)component_pool::PAGE_SZ);
+			}
+		}
+		WHEN("Room is reserved") {
+			cp.reserve(component_pool::PAGE_SZ + 1);
+			THEN("Enough pages are allocated up front") {
+				REQUIRE(cp.capacity() == component_pool::PAGE_SZ * 2);
+				REQUIRE(cp.count() == 0);
+			}
+		}
+		WHEN("Room is reserved, then the pool shrinks to fit") {
+			cp.reserve(component_pool::PAGE_SZ * 3);
+			cp.add<int>(7, 7);
+			size_t released = cp.shrink_to_fit();
+			THEN("Only the page in use is kept") {
+				REQUIRE(released >= component_pool::PAGE_SZ * 2 * sizeof(int));
+				REQUIRE(cp.capacity() == component_pool::PAGE_SZ);
+				REQUIRE(*cp.get<int>(7) == 7);
+			}
+		}
+	}
+}
+
+TEST_CASE("Component pools manage component lifetimes", "[component_pool]") {
+	using namespace ecs;
+	GIVEN("A pool of components with a destructor") {
+		{
+			component_pool cp(component_pool::unlimited, sizeof(tracked), {}, lifecycle::of<tracked>());
+			for (size_t i = 0; i < component_pool::PAGE_SZ + 10; ++i) {
+				cp.add<tracked>(i, std::to_string(i));
+			}
+			REQUIRE(tracked::alive == (int)component_pool::PAGE_SZ + 10);
+			WHEN("Components are removed") {
+				cp.remove(0);
+				cp.remove(5);
+				THEN("They are destroyed, and the last ones moved into their place") {
+					REQUIRE(tracked::alive == (int)component_pool::PAGE_SZ + 8);
+					REQUIRE(cp.get<tracked>(component_pool::PAGE_SZ + 9)->name == std::to_string(component_pool::PAGE_SZ + 9));
+					REQUIRE(cp.get<tracked>(component_pool::PAGE_SZ + 8)->name == std::to_string(component_pool::PAGE_SZ + 8));
+				}
+			}
+			WHEN("Components are swapped and cloned") {
+				cp.swap(1, component_pool::PAGE_SZ + 1);
+				cp.clone(1, 5000);
+				THEN("Each keeps its own value") {
+					REQUIRE(cp.get<tracked>(1)->name == "1");
+					REQUIRE(cp.get<tracked>(5000)->name == "1");
+					REQUIRE(cp.get<tracked>(component_pool::PAGE_SZ + 1)->name == std::to_string(component_pool::PAGE_SZ + 1));
+					REQUIRE(tracked::alive == (int)component_pool::PAGE_SZ + 11);
+				}
+			}
+		}
+		THEN("Destroying the pool destroys what is left") {
+			REQUIRE(tracked::alive == 0);
+		}
+	}
+	GIVEN("A pool of components whose construction can throw") {
+		{
+			component_pool cp(component_pool::unlimited, sizeof(fragile), {}, lifecycle::of<fragile>());
+			cp.add<fragile>(1, "one");
+			cp.add<fragile>(2, "nocopy");
+			WHEN("Adding or cloning a component throws") {
+				REQUIRE_THROWS_AS(cp.add<fragile>(3, ""), std::invalid_argument);
+				REQUIRE_THROWS_AS(cp.clone(2, 4), std::runtime_error);
+				THEN("The entity is left out of the pool") {
+					REQUIRE(cp.count() == 2);
+					REQUIRE(!cp.contains(3));
+					REQUIRE(!cp.contains(4));
+					REQUIRE(fragile::alive == 2);
+					cp.add<fragile>(3, "three");
+					cp.clone(1, 4);
+					REQUIRE(cp.get<fragile>(3)->name == "three");
+					REQUIRE(cp.get<fragile>(4)->name == "one");
+				}
+			}
+		}
+		THEN("Nothing is left alive") {
+			REQUIRE(fragile::alive == 0);
+		}
+	}
+	GIVEN("A pool of move-only components") {
+		using owned = std::unique_ptr<int>;
+		component_pool cp(component_pool::unlimited, sizeof(owned), {}, lifecycle::of<owned>());
+		cp.add<owned>(1, new int(1));
+		cp.add<owned>(2, new int(2));
+		cp.remove(1);
+		THEN("They are moved rather than copied") {
+			REQUIRE(**cp.get<owned>(2) == 2);
+			REQUIRE(!cp.copyable());
+			REQUIRE_THROWS_AS(cp.clone(2, 3), std::runtime_error);
+		}
+	}
+	THEN("Plain components are copied as bytes") {
+		constexpr lifecycle ops = lifecycle::of<int>();
+		REQUIRE(ops.copy == nullptr);
+		REQUIRE(ops.relocate == nullptr);
+		REQUIRE(ops.destroy == nullptr);
+		REQUIRE(lifecycle::of<tracked>().relocate != nullptr);
+	}
 }
@@ -0,0 +1,164 @@
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ecs.hpp>
+
+struct delta_position {
+	float x;
+	float y;
+	float z;
+};
+
+struct delta_stats {
+	int hp;
+	int mana;
+	char tag[32];
+};
+
+/// a delta_stats with the given tag
+static delta_stats stats(int hp, int mana, const char* tag) {
+	delta_stats s{ hp, mana, {} };
+	std::strncpy(s.tag, tag, sizeof(s.tag) - 1);
+	return s;
+}
+
+/// registers the replicated types of this test
+static void register_types(ecs::registry& reg) {
+	reg.register_component<delta_position>("position");
+	reg.register_component<delta_stats>("stats");
+}
+
+/// true if both registries hold the same entities with the same components
+static bool same(const ecs::registry& a, const ecs::registry& b) {
+	using namespace ecs;
+	if (a.count() != b.count()) return false;
+	for (entity_id id : a.entities()) {
+		if (!b.valid(id)) return false;
+		entity_t ea = a.at(id);
+		entity_t eb = b.at(id);
+		if (ea->has<delta_position>() != eb->has<delta_position>()) return false;
+		if (ea->has<delta_stats>() != eb->has<delta_stats>()) return false;
+		if (ea->has<delta_position>()) {
+			const delta_position& pa = ea->get<delta_position>();
+			const delta_position& pb = eb->get<delta_position>();
+			if (pa.x != pb.x || pa.y != pb.y || pa.z != pb.z) return false;
+		}
+		if (ea->has<delta_stats>()) {
+			const delta_stats& sa = ea->get<delta_stats>();
+			const delta_stats& sb = eb->get<delta_stats>();
+			if (sa.hp != sb.hp || sa.mana != sb.mana || std::string(sa.tag) != std::string(sb.tag)) return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("Delta replication works", "[delta]") {
+	using namespace ecs;
+	GIVEN("A registry replicated to another") {
+		registry world, replica;
+		register_types(world);
+		register_types(replica);
+		std::vector<entity_t> ents;
+		world.create_many(500, std::back_inserter(ents));
+		for (size_t i = 0; i < ents.size(); ++i) {
+			ents[i]->add<delta_position>(float(i), 0.f, 0.f);
+			if (i % 2 == 0) ents[i]->add<delta_stats>(stats(100, 50, "unit"));
+		}
+		delta_encoder enc(world);
+		delta_decoder dec(replica);
+		std::vector<char> full = enc.encode();
+		dec.apply(full);
+		REQUIRE(same(world, replica));
+		REQUIRE(dec.tick() == 1);
+
+		WHEN("Nothing changes") {
+			std::vector<char> delta = enc.encode();
+			dec.apply(delta);
+			THEN("The delta is tiny") {
+				REQUIRE(delta.size() < 32);
+				REQUIRE(same(world, replica));
+			}
+		}
+		WHEN("A few bytes of a few components change") {
+			for (size_t i = 0; i < ents.size(); i += 50) {
+				ents[i]->get<delta_position>().y += 1.f;
+			}
+			ents[2]->get<delta_stats>().hp = 99;
+			std::vector<char> delta = enc.encode();
+			dec.apply(delta);
+			THEN("Only the changed bytes are sent") {
+				REQUIRE(same(world, replica));
+				REQUIRE(delta.size() < 11 * (sizeof(entity_id) + 8) + 64);
+			}
+		}
+		WHEN("Entities and components come and go") {
+			world.remove(ents[3]);
+			world.remove(ents[4]);
+			ents[5]->remove<delta_position>();
+			ents[7]->add<delta_stats>(stats(1, 2, "new"));
+			entity_t fresh = world.create();
+			fresh->add<delta_position>(9.f, 9.f, 9.f);
+			dec.apply(enc.encode());
+			ents[6]->get<delta_position>().z = -1.f;
+			dec.apply(enc.encode());
+			THEN("The replica follows") {
+				REQUIRE(same(world, replica));
+				REQUIRE(replica.valid(fresh.id()));
+				REQUIRE(!replica.valid(ents[3].id()));
+			}
+		}
+		WHEN("A delta is skipped") {
+			enc.encode();
+			ents[0]->get<delta_position>().x = 7.f;
+			std::vector<char> delta = enc.encode();
+			THEN("The replica refuses the next one") {
+				REQUIRE_THROWS_AS(dec.apply(delta), std::runtime_error);
+			}
+			THEN("Resetting the encoder sends everything again") {
+				enc.reset();
+				dec.apply(enc.encode());
+				REQUIRE(same(world, replica));
+			}
+		}
+		WHEN("A delta encoded against another registry doesn't fit the replica") {
+			// same entity ids, but different components
+			registry other;
+			register_types(other);
+			std::vector<entity_t> others;
+			other.create_many(ents.size(), std::back_inserter(others));
+			delta_encoder forged(other);
+			forged.encode();
+			other.create();
+			others[0]->add<delta_position>(1.f, 2.f, 3.f);
+			others[1]->add<delta_stats>(stats(1, 1, "odd"));
+			std::vector<char> adding = forged.encode();
+			others[1]->get<delta_stats>().hp = 2;
+			std::vector<char> changing = forged.encode();
+			THEN("Nothing is applied") {
+				REQUIRE_THROWS_AS(dec.apply(adding), std::runtime_error);
+				REQUIRE(replica.count() == ents.size());
+				REQUIRE(same(world, replica));
+				REQUIRE(dec.tick() == 1);
+			}
+			THEN("Changing a component the replica doesn't have is refused too") {
+				dec.apply(enc.encode());
+				REQUIRE_THROWS_AS(dec.apply(changing), std::runtime_error);
+				REQUIRE(same(world, replica));
+			}
+		}
+		WHEN("The replica doesn't know a type") {
+			registry other;
+			other.register_component<delta_position>("position");
+			delta_decoder partial(other);
+			THEN("Nothing is applied") {
+				REQUIRE_THROWS_AS(partial.apply(full), std::runtime_error);
+				REQUIRE(other.count() == 0);
+			}
+		}
+	}
+}
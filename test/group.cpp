@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <span>
+#include <stdexcept>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	int x;
+	int y;
+};
+
+struct velocity {
+	int x;
+	int y;
+};
+
+struct tag {
+	int id;
+};
+}
+
+TEST_CASE("Owning groups work.", "[group]") {
+	using namespace ecs;
+	GIVEN("Some entities, only some having every component") {
+		registry reg;
+		std::vector<entity_t> ents;
+		for (int i = 0; i < 3000; ++i) {
+			auto e = reg.create();
+			e->add<position>(i, 0);
+			if (i % 3 == 0) e->add<velocity>(1, 1);
+			e->add<tag>(i);
+			ents.push_back(e);
+		}
+		auto g = reg.group<position, velocity>();
+		THEN("Entities having every component are packed at the front of each pool, in the same order") {
+			REQUIRE(g.size() == 1000);
+			auto& ps = reg.pool(typeid(position)).entities();
+			auto& vs = reg.pool(typeid(velocity)).entities();
+			for (size_t i = 0; i < g.size(); ++i) {
+				REQUIRE(ps[i] == vs[i]);
+			}
+		}
+		THEN("Iterating the group visits every member once") {
+			std::set<int> seen;
+			g.each([&seen](entity_t e, position& p, velocity& v) {
+				REQUIRE(e->get<position>().x == p.x);
+				REQUIRE(e->has<velocity>());
+				REQUIRE(p.x % 3 == 0);
+				seen.insert(p.x);
+			});
+			REQUIRE(seen.size() == 1000);
+		}
+		THEN("Components retrieved through the entity are those of the group") {
+			g.each([](position& p, velocity& v) {
+				p.y += v.y;
+			});
+			for (int i = 0; i < 3000; ++i) {
+				REQUIRE(ents[i]->get<position>().x == i);
+				REQUIRE(ents[i]->get<position>().y == (i % 3 == 0 ? 1 : 0));
+				REQUIRE(ents[i]->get<tag>().id == i);
+			}
+		}
+		WHEN("A component is added completing an entity") {
+			auto& v = ents[1]->add<velocity>(5, 5);
+			THEN("It joins the group") {
+				REQUIRE(g.size() == 1001);
+				REQUIRE(g.contains(ents[1]));
+				REQUIRE(v.x == 5);
+				REQUIRE(&v == &ents[1]->get<velocity>());
+			}
+		}
+		WHEN("A component is removed from a member") {
+			ents[3]->remove<velocity>();
+			reg.remove(ents[6]);
+			THEN("It leaves the group") {
+				REQUIRE(g.size() == 998);
+				REQUIRE_FALSE(g.contains(ents[3]));
+				REQUIRE(g.contains(ents[9]));
+				size_t n = 0;
+				g.each([&n](position& p, velocity&) {
+					REQUIRE(p.x != 3);
+					REQUIRE(p.x != 6);
+					n++;
+				});
+				REQUIRE(n == 998);
+			}
+		}
+		WHEN("A member is cloned") {
+			auto c = ents[0]->clone();
+			THEN("The clone joins the group") {
+				REQUIRE(g.size() == 1001);
+				REQUIRE(g.contains(c));
+			}
+		}
+		WHEN("The group is iterated in parallel") {
+			reg.use_workers(std::make_shared<thread_pool>(4));
+			g.par_each([](position& p, velocity& v) {
+				p.y += v.y;
+			}, par_options{ 64 });
+			THEN("Every member is updated") {
+				g.each([](const position& p, const velocity&) {
+					REQUIRE(p.y == 1);
+				});
+			}
+		}
+		WHEN("The group is iterated in chunks") {
+			size_t total = 0;
+			g.each_chunk([&total](std::span<position> ps, std::span<velocity> vs) {
+				REQUIRE(ps.size() == vs.size());
+				REQUIRE(reinterpret_cast<std::uintptr_t>(ps.data()) % component_pool::PAGE_ALIGN == 0);
+				for (size_t i = 0; i < ps.size(); ++i) {
+					ps[i].y += vs[i].y;
+				}
+				total += ps.size();
+			});
+			THEN("Every member is visited once") {
+				REQUIRE(total == 1000);
+				g.each([](const position& p, const velocity&) {
+					REQUIRE(p.y == 1);
+				});
+			}
+		}
+		WHEN("The same group is retrieved again") {
+			auto again = reg.group<velocity, position>();
+			THEN("It shares its members") {
+				REQUIRE(again.size() == g.size());
+			}
+		}
+		THEN("A pool can't be owned by two different groups") {
+			REQUIRE_THROWS_AS((reg.group<position, tag>()), std::runtime_error);
+			REQUIRE_THROWS_AS((reg.group<tag, tag>()), std::runtime_error);
+		}
+		THEN("Views over the owned pools still work") {
+			size_t n = 0;
+			reg.view<velocity, position, tag>().each([&n](velocity&, position& p, tag& t) {
+				REQUIRE(p.x == t.id);
+				n++;
+			});
+			REQUIRE(n == 1000);
+		}
+	}
+}
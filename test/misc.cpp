@@ -60,12 +60,12 @@ struct fn {
 TEST_CASE("Miscellaneous edge case testing") {
 	registry reg;
 	auto e	= reg.create();
-	auto e2 = reg.create(), e3 = reg.create();
+	auto e2 = reg.create();
+	reg.create();
 	e2->add<fn>([e]() -> int {
 		return 3;
 	});
 	e->add<positionVector>();
-	exit(0);
 	positionVector& posV = e->get<positionVector>();
 	REQUIRE(posV.pos[0].x == 2);
 	e->get<positionVector>().push_five();
@@ -85,7 +85,7 @@ TEST_CASE("Miscellaneous edge case testing") {
 	e->add<fn>([e]() -> int {
 		return e->get<positionVector>().pos.back().x;
 	});
-	for (auto& [fn] : reg.view<fn>()) {
+	for (auto [fn] : reg.view<fn>()) {
 		REQUIRE(fn.internal() == 3);
 	}
 	e->get<positionVector>().failable = false;
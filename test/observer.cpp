@@ -0,0 +1,161 @@
+#include <catch2/catch.hpp>
+
+#include <iterator>
+#include <vector>
+
+#include <ecs.hpp>
+
+struct observed {
+	int value;
+};
+
+TEST_CASE("Registries signal component events", "[observer]") {
+	using namespace ecs;
+	GIVEN("A registry with listeners on a component type") {
+		registry reg;
+		std::vector<entity_id> constructed, destroyed, updated;
+		int seen_value = -1;
+		reg.on_construct<observed>().connect([&](entity_t e) {
+			constructed.push_back(e.id());
+			seen_value = e->get<observed>().value;
+		});
+		size_t on_destroy = reg.on_destroy<observed>().connect([&](entity_t e) {
+			REQUIRE(e->has<observed>());
+			destroyed.push_back(e.id());
+		});
+		reg.on_update<observed>().connect([&](entity_t e) {
+			updated.push_back(e.id());
+		});
+		entity_t a = reg.create();
+		entity_t b = reg.create();
+
+		WHEN("Components are added, patched and removed") {
+			a->add<observed>(4);
+			b->add<observed>(5);
+			a->patch<observed>([](observed& o) {
+				o.value++;
+			});
+			a->remove<observed>();
+			reg.remove(b);
+			THEN("Each listener is called") {
+				REQUIRE(constructed == std::vector<entity_id>{ a.id(), b.id() });
+				REQUIRE(seen_value == 5);
+				REQUIRE(updated == std::vector<entity_id>{ a.id() });
+				REQUIRE(destroyed == std::vector<entity_id>{ a.id(), b.id() });
+			}
+		}
+		WHEN("An entity is cloned") {
+			a->add<observed>(1);
+			entity_t c = a->clone();
+			THEN("Its components are constructed") {
+				REQUIRE(constructed == std::vector<entity_id>{ a.id(), c.id() });
+			}
+		}
+		WHEN("A listener is disconnected") {
+			reg.on_destroy<observed>().disconnect(on_destroy);
+			a->add<observed>(1);
+			a->remove<observed>();
+			THEN("It is no longer called") {
+				REQUIRE(destroyed.empty());
+			}
+		}
+	}
+	GIVEN("An observer collecting patched components") {
+		registry reg;
+		std::vector<entity_t> ents;
+		reg.create_many(10, std::back_inserter(ents));
+		for (auto& e : ents) {
+			e->add<observed>(0);
+		}
+		observer moved;
+		reg.on_update<observed>().collect(moved);
+		reg.on_construct<observed>().collect(moved);
+
+		WHEN("Some are patched, some several times") {
+			auto bump = [](observed& o) {
+				o.value++;
+			};
+			ents[3]->patch<observed>(bump);
+			ents[7]->patch<observed>(bump);
+			ents[3]->patch<observed>(bump);
+			THEN("Each is recorded once, in order") {
+				REQUIRE(moved.entities() == std::vector<entity_id>{ ents[3].id(), ents[7].id() });
+			}
+			THEN("Draining empties it") {
+				int total = 0;
+				moved.drain([&total](entity_t e) {
+					total += e->get<observed>().value;
+				});
+				REQUIRE(total == 3);
+				REQUIRE(moved.empty());
+				ents[3]->patch<observed>(bump);
+				REQUIRE(moved.size() == 1);
+			}
+		}
+		WHEN("An index is reused") {
+			ents[2]->patch<observed>([](observed&) {});
+			reg.remove(ents[2]);
+			entity_t fresh = reg.create();
+			fresh->add<observed>(0);
+			THEN("Both generations are recorded") {
+				REQUIRE(moved.size() == 2);
+				REQUIRE(entity_index(moved.entities()[0]) == entity_index(moved.entities()[1]));
+			}
+		}
+		WHEN("The observer is disconnected") {
+			moved.disconnect();
+			ents[0]->patch<observed>([](observed&) {});
+			THEN("Nothing is recorded") {
+				REQUIRE(moved.empty());
+			}
+		}
+		WHEN("The observer is destroyed") {
+			{
+				observer temp;
+				reg.on_update<observed>().collect(temp);
+			}
+			ents[0]->patch<observed>([](observed&) {});
+			THEN("Its listener is gone") {
+				REQUIRE(moved.size() == 1);
+			}
+		}
+	}
+	GIVEN("An observer moved from one registry to another") {
+		registry first, second;
+		observer obs;
+		first.on_construct<observed>().collect(obs);
+		first.create()->add<observed>(1);
+		first.create()->add<observed>(2);
+		obs.disconnect();
+		second.on_construct<observed>().collect(obs);
+		entity_t e = second.create();
+		e->add<observed>(3);
+		first.create()->add<observed>(4);
+		THEN("It only reports the entities of the second registry") {
+			std::vector<entity_t> seen;
+			obs.each([&seen](entity_t e) {
+				seen.push_back(e);
+			});
+			REQUIRE(seen.size() == 1);
+			REQUIRE(seen[0] == e);
+			REQUIRE(seen[0]->get<observed>().value == 3);
+		}
+	}
+	GIVEN("An observer outliving the registry it collects from") {
+		observer obs;
+		{
+			registry reg;
+			reg.on_construct<observed>().collect(obs);
+			reg.on_update<observed>().collect(obs);
+			reg.create()->add<observed>(1);
+		}
+		THEN("The registry disconnected it, so it can be destroyed") {
+			REQUIRE(obs.size() == 1);
+			obs.disconnect();
+			registry other;
+			other.on_construct<observed>().collect(obs);
+			other.create()->add<observed>(2);
+			REQUIRE(obs.size() == 1);
+		}
+	}
+}
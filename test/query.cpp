@@ -0,0 +1,125 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	int x;
+	int y;
+};
+
+struct velocity {
+	int x;
+	int y;
+};
+
+struct frozen {
+	bool yes;
+};
+
+struct tint {
+	int color;
+};
+
+struct never_added {
+	int v;
+};
+}
+
+TEST_CASE("Cached queries work.", "[query]") {
+	using namespace ecs;
+	GIVEN("Some entities, only some matching the query") {
+		registry reg;
+		std::vector<entity_t> ents;
+		for (int i = 0; i < 300; ++i) {
+			auto e = reg.create();
+			e->add<position>(i, 0);
+			if (i % 3 == 0) e->add<velocity>(1, 1);
+			if (i % 5 == 0) e->add<frozen>(true);
+			if (i % 2 == 0) e->add<tint>(i);
+			ents.push_back(e);
+		}
+		auto q = reg.query<position, velocity, exclude<frozen>>();
+		// multiples of 3 that aren't multiples of 5
+		auto expected = [&ents]() {
+			size_t n = 0;
+			for (auto& e : ents) {
+				if (e->alive() && e->has<position, velocity>() && !e->has<frozen>()) n++;
+			}
+			return n;
+		};
+		THEN("The entities already there are cached") {
+			REQUIRE(q.size() == 80);
+			REQUIRE(q.size() == expected());
+			std::set<int> seen;
+			q.each([&seen](entity_t e, position& p, velocity& v) {
+				REQUIRE(p.x % 3 == 0);
+				REQUIRE(p.x % 5 != 0);
+				REQUIRE(!e->has<frozen>());
+				seen.insert(p.x);
+			});
+			REQUIRE(seen.size() == q.size());
+		}
+		THEN("Retrieving it again shares the cache") {
+			auto again = reg.query<position, velocity, exclude<frozen>>();
+			REQUIRE(again.entities().data() == q.entities().data());
+		}
+		WHEN("Components are added and removed") {
+			ents[1]->add<velocity>(2, 2);
+			ents[3]->remove<velocity>();
+			ents[6]->add<frozen>(true);
+			ents[15]->remove<frozen>();
+			THEN("The cache follows") {
+				REQUIRE(q.contains(ents[1]));
+				REQUIRE(!q.contains(ents[3]));
+				REQUIRE(!q.contains(ents[6]));
+				REQUIRE(q.contains(ents[15]));
+				REQUIRE(q.size() == expected());
+			}
+		}
+		WHEN("Entities are removed, cloned or created") {
+			reg.remove(ents[3]);
+			auto c = ents[9]->clone();
+			auto n = reg.create();
+			n->add<velocity>(0, 0);
+			n->add<position>(0, 0);
+			THEN("The cache follows") {
+				REQUIRE(!q.contains(ents[3]));
+				REQUIRE(q.contains(c));
+				REQUIRE(q.contains(n));
+				REQUIRE(q.size() == 81);
+			}
+		}
+		THEN("Optional components are handed out if present") {
+			auto opt = reg.query<position, optional<tint>>();
+			REQUIRE(opt.size() == 300);
+			size_t tinted = 0;
+			opt.each([&tinted](position& p, tint* t) {
+				REQUIRE((t != nullptr) == (p.x % 2 == 0));
+				if (t) tinted++;
+			});
+			REQUIRE(tinted == 150);
+		}
+		THEN("A query of a component never added starts empty, and fills up") {
+			auto none = reg.query<position, never_added>();
+			REQUIRE(none.size() == 0);
+			none.each([](position&, never_added&) {
+				FAIL("nothing matches");
+			});
+			ents[4]->add<never_added>(1);
+			REQUIRE(none.size() == 1);
+			REQUIRE(none.contains(ents[4]));
+		}
+		THEN("Components are changed through the query") {
+			q.each([](position& p, velocity& v) {
+				p.y += v.y;
+			});
+			REQUIRE(ents[3]->get<position>().y == 1);
+			REQUIRE(ents[15]->get<position>().y == 0);
+		}
+	}
+}
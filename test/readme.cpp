@@ -19,11 +19,10 @@ static void movement_system(registry& reg) {
 	// view all objects with a position and velocity
 	view v = reg.view<position, velocity>();
 	// iteration via a range-based for loop
-	for (auto& [position, velocity] : v) {
+	for (auto [position, velocity] : v) {
 		position.x += velocity.x;
 		position.y += velocity.y;
 	}
-	exit(0);
 }
 
 static void game_tick(registry& reg) {
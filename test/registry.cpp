@@ -1,5 +1,11 @@
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
 #include <ecs.hpp>
 
 struct position {
@@ -13,6 +19,10 @@ struct color {
 	float b;
 };
 
+struct marker {
+	int value;
+};
+
 TEST_CASE("Entity registry works.") {
 	using namespace ecs;
 	GIVEN("An entity registry.") {
@@ -53,5 +63,245 @@ TEST_CASE("Entity registry works.") {
 				}
 			}
 		}
+		WHEN("We remove an entity") {
+			auto e1 = reg.create();
+			e1->add<position>(1, 2);
+			entity_id old = e1->id();
+			reg.remove(e1);
+			THEN("Its handle is no longer valid") {
+				REQUIRE(!e1->alive());
+				REQUIRE(!reg.valid(old));
+				REQUIRE(reg.count() == 0);
+				REQUIRE_THROWS(e1->get<position>());
+			}
+			THEN("Its index is recycled with a new generation") {
+				auto e2 = reg.create();
+				REQUIRE(entity_index(e2->id()) == entity_index(old));
+				REQUIRE(entity_generation(e2->id()) == entity_generation(old) + 1);
+				REQUIRE(!e2->has<position>());
+				REQUIRE(!e1->alive());
+				REQUIRE(e2->alive());
+			}
+			THEN("Removing it again does nothing") {
+				reg.remove(e1);
+				REQUIRE(reg.count() == 0);
+			}
+		}
+		WHEN("We reserve room for a component") {
+			reg.reserve<position>(2000);
+			THEN("Its pool fits that many without growing") {
+				REQUIRE(reg.pool(typeid(position)).capacity() >= 2000);
+				REQUIRE(reg.pool(typeid(position)).count() == 0);
+			}
+		}
+	}
+	GIVEN("Many entities created at once") {
+		registry reg;
+		auto old = reg.create();
+		reg.remove(old);
+		std::vector<entity_t> ents;
+		reg.create_many(5000, std::back_inserter(ents));
+		REQUIRE(ents.size() == 5000);
+		REQUIRE(reg.count() == 5000);
+		THEN("Their ids are unique, recycling removed ones") {
+			std::set<entity_id> ids;
+			for (auto& e : ents) {
+				REQUIRE(e.alive());
+				ids.insert(e.id());
+			}
+			REQUIRE(ids.size() == 5000);
+			REQUIRE(entity_index(ents[0].id()) == entity_index(old.id()));
+		}
+		WHEN("A component is inserted into all of them") {
+			reg.insert<position>(ents.begin(), ents.end(), position{ 3, 4 });
+			THEN("Each has a copy") {
+				REQUIRE(reg.pool(typeid(position)).count() == 5000);
+				for (auto& e : ents) {
+					REQUIRE(e->get<position>().y == 4);
+				}
+			}
+		}
+		WHEN("A range of components is inserted") {
+			std::vector<color> colors;
+			for (size_t i = 0; i < ents.size(); ++i) {
+				colors.push_back(color{ float(i), 0, 0 });
+			}
+			reg.insert<color>(ents.begin(), ents.end(), colors.begin());
+			THEN("Each entity has its own") {
+				for (size_t i = 0; i < ents.size(); ++i) {
+					REQUIRE(ents[i]->get<color>().r == float(i));
+				}
+			}
+		}
+		WHEN("Inserting into an entity that already has the component") {
+			ents[10]->add<position>(1, 1);
+			THEN("Nothing is inserted") {
+				REQUIRE_THROWS_AS(reg.insert<position>(ents.begin(), ents.end()), std::runtime_error);
+				REQUIRE(reg.pool(typeid(position)).count() == 1);
+			}
+		}
+		WHEN("Inserting into a range listing an entity twice") {
+			std::vector<entity_t> twice(ents.begin(), ents.begin() + 10);
+			twice.push_back(ents[3]);
+			THEN("Nothing is inserted") {
+				REQUIRE_THROWS_AS(reg.insert<position>(twice.begin(), twice.end()), std::runtime_error);
+				REQUIRE(reg.pool(typeid(position)).count() == 0);
+			}
+		}
+		WHEN("Inserting into components of a group") {
+			auto g = reg.group<position, color>();
+			reg.insert<position>(ents.begin(), ents.begin() + 100);
+			reg.insert<color>(ents.begin() + 50, ents.end());
+			THEN("The group is kept up to date") {
+				REQUIRE(g.size() == 50);
+			}
+		}
+	}
+	GIVEN("Entities created with given ids, out of order") {
+		registry reg;
+		for (size_t i = 0; i < 1000; ++i) {
+			reg.create(make_entity_id(999 - i, 1));
+		}
+		reg.create(make_entity_id(1500, 0));
+		THEN("Each index is taken once") {
+			REQUIRE(reg.count() == 1001);
+			REQUIRE(reg.valid(make_entity_id(0, 1)));
+			REQUIRE_THROWS_AS(reg.create(make_entity_id(500, 2)), std::runtime_error);
+		}
+		THEN("The indices skipped over are taken by given ids, then recycled") {
+			reg.create(make_entity_id(1200, 0));
+			REQUIRE_THROWS_AS(reg.create(make_entity_id(1200, 1)), std::runtime_error);
+			std::set<size_t> indices;
+			for (size_t i = 0; i < 499; ++i) {
+				indices.insert(entity_index(reg.create().id()));
+			}
+			REQUIRE(indices.size() == 499);
+			REQUIRE(*indices.begin() == 1000);
+			REQUIRE(*indices.rbegin() == 1499);
+			REQUIRE(indices.count(1200) == 0);
+			REQUIRE(entity_index(reg.create().id()) == 1501);
+		}
+	}
+	GIVEN("An entity registry with a hard cap") {
+		registry reg(2);
+		reg.create()->add<position>(1, 2);
+		reg.create()->add<position>(3, 4);
+		THEN("Adding past the cap throws") {
+			REQUIRE_THROWS(reg.create()->add<position>(5, 6));
+			REQUIRE_THROWS(reg.reserve<color>(3));
+		}
+	}
+}
+
+TEST_CASE("Registries compact their pools.") {
+	using namespace ecs;
+	GIVEN("A pool filled in reverse, then mostly emptied") {
+		registry reg;
+		std::vector<entity_t> ents;
+		reg.create_many(component_pool::PAGE_SZ * 4, std::back_inserter(ents));
+		for (size_t i = ents.size(); i-- > 0;) {
+			ents[i]->add<position>((int)i, 0);
+		}
+		for (size_t i = 0; i < ents.size(); ++i) {
+			if (i % 8 != 0) ents[i]->remove<position>();
+		}
+		auto sorted = [&reg]() {
+			const auto& ids = reg.pool(typeid(position)).entities();
+			return std::is_sorted(ids.begin(), ids.end(), [](entity_id a, entity_id b) {
+				return entity_index(a) < entity_index(b);
+			});
+		};
+		auto intact = [&]() {
+			for (size_t i = 0; i < ents.size(); i += 8) {
+				if (ents[i]->get<position>().x != (int)i) return false;
+			}
+			return true;
+		};
+		REQUIRE(!sorted());
+		WHEN("It is compacted at once") {
+			size_t released = reg.compact<position>();
+			THEN("It is sorted, with the pages it doesn't need released") {
+				REQUIRE(released >= 3 * component_pool::PAGE_SZ * sizeof(position));
+				REQUIRE(sorted());
+				REQUIRE(intact());
+				REQUIRE(reg.pool(typeid(position)).capacity() == component_pool::PAGE_SZ);
+				REQUIRE(reg.compact() == 0);
+			}
+		}
+		WHEN("It is compacted a bit at a time") {
+			size_t calls = 0;
+			do {
+				reg.compact(64);
+				calls++;
+			} while (!sorted() && calls < 1000);
+			THEN("It gets sorted within the budget of each call") {
+				REQUIRE(sorted());
+				REQUIRE(calls >= component_pool::PAGE_SZ / 2 / 64);
+				REQUIRE(intact());
+			}
+		}
+		WHEN("Entities come and go between increments") {
+			reg.compact(16);
+			ents[8]->remove<position>();
+			ents[1]->add<position>(1, 0);
+			reg.compact(component_pool::PAGE_SZ * 4);
+			THEN("The pool starts over and still gets sorted") {
+				REQUIRE(sorted());
+				REQUIRE(ents[1]->get<position>().x == 1);
+				REQUIRE(!ents[8]->has<position>());
+			}
+		}
+		WHEN("The pool is owned by a group") {
+			for (size_t i = 0; i < ents.size(); i += 16) {
+				ents[i]->add<color>();
+			}
+			auto g = reg.group<position, color>();
+			reg.compact();
+			THEN("Its order is left alone") {
+				REQUIRE(g.size() == component_pool::PAGE_SZ / 4);
+				for (size_t i = 0; i < ents.size(); i += 16) {
+					REQUIRE(g.contains(ents[i]));
+				}
+				REQUIRE(intact());
+			}
+		}
+		WHEN("A group takes the pool over between increments") {
+			// another pool of the same entities, sorted but for its first 16, which a stale cursor would skip
+			for (size_t i = 16 * 8; i-- > 0;) {
+				if (i % 8 == 0) ents[i]->add<marker>((int)i);
+			}
+			for (size_t i = 16 * 8; i < ents.size(); i += 8) {
+				ents[i]->add<marker>((int)i);
+			}
+			reg.compact(16);
+			auto g = reg.group<position, color>();
+			reg.compact(component_pool::PAGE_SZ * 4);
+			THEN("The next pool is sorted from its start") {
+				const auto& ids = reg.pool(typeid(marker)).entities();
+				REQUIRE(std::is_sorted(ids.begin(), ids.end(), [](entity_id a, entity_id b) {
+					return entity_index(a) < entity_index(b);
+				}));
+				REQUIRE(g.size() == 0);
+			}
+		}
+	}
+}
+
+TEST_CASE("Component ids are dense and stable.") {
+	using namespace ecs;
+	size_t pos = component_id<position>();
+	size_t col = component_id<color>();
+	REQUIRE(pos != col);
+	REQUIRE(component_id<position>() == pos);
+	REQUIRE(component_id<color>() == col);
+	GIVEN("A registry with a component") {
+		registry reg;
+		reg.create()->add<color>(.1f, .2f, .3f);
+		THEN("Its pool can be found by id and by type index") {
+			REQUIRE(reg.find_pool<color>() != nullptr);
+			REQUIRE(reg.find_pool<color>() == reg.find_pool(typeid(color)));
+			REQUIRE(reg.find_pool<position>() == nullptr);
+			REQUIRE(reg.find_pool(typeid(position)) == nullptr);
+		}
 	}
 }
@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct position {
+	int x;
+	int y;
+};
+
+struct velocity {
+	int x;
+	int y;
+};
+
+struct health {
+	int hp;
+};
+}
+
+TEST_CASE("Scheduling systems works.", "[scheduler]") {
+	using namespace ecs;
+	GIVEN("A registry with some moving entities") {
+		registry reg;
+		reg.use_workers(std::make_shared<thread_pool>(4));
+		for (int i = 0; i < 5000; ++i) {
+			auto e = reg.create();
+			e->add<position>(0, 0);
+			e->add<velocity>(1, 2);
+			if (i % 2 == 0) e->add<health>(10);
+		}
+		scheduler sched(reg);
+		WHEN("Systems touching disjoint components are added") {
+			sched.add<reads<velocity>, writes<position>>([](position& p, const velocity& v) {
+				p.x += v.x;
+				p.y += v.y;
+			});
+			sched.add<writes<health>>([](health& h) {
+				h.hp--;
+			});
+			THEN("They share a stage") {
+				REQUIRE(sched.size() == 2);
+				REQUIRE(sched.stages() == 1);
+				REQUIRE(sched.stage(0) == 0);
+				REQUIRE(sched.stage(1) == 0);
+			}
+			THEN("Running them updates every entity") {
+				sched.run();
+				sched.run();
+				reg.view<position, velocity>().each([](const position& p, const velocity&) {
+					REQUIRE(p.x == 2);
+					REQUIRE(p.y == 4);
+				});
+				size_t n = 0;
+				reg.view<health>().each([&n](const health& h) {
+					REQUIRE(h.hp == 8);
+					n++;
+				});
+				REQUIRE(n == 2500);
+			}
+		}
+		WHEN("Systems only reading the same component are added") {
+			std::atomic<size_t> seen(0);
+			auto count = [&seen](const velocity&) {
+				seen++;
+			};
+			sched.add<reads<velocity>>(count);
+			sched.add<reads<velocity>>(count);
+			THEN("They share a stage") {
+				REQUIRE(sched.stages() == 1);
+				sched.run();
+				REQUIRE(seen == 10000);
+			}
+		}
+		WHEN("Conflicting systems are added") {
+			sched.add<writes<position>>([](position& p) {
+				p.x = 1;
+			});
+			sched.add<reads<velocity>>([](const velocity&) {});
+			sched.add<reads<position>, writes<velocity>>([](const position& p, velocity& v) {
+				v.x = p.x * 10;
+			});
+			sched.add<writes<position>>([](position& p) {
+				p.x = 3;
+			});
+			THEN("They run in the order they were added") {
+				REQUIRE(sched.stage(0) == 0);
+				REQUIRE(sched.stage(1) == 0);
+				REQUIRE(sched.stage(2) == 1);
+				REQUIRE(sched.stage(3) == 2);
+				REQUIRE(sched.stages() == 3);
+				sched.run();
+				reg.view<position, velocity>().each([](const position& p, const velocity& v) {
+					REQUIRE(v.x == 10);
+					REQUIRE(p.x == 3);
+				});
+			}
+		}
+		WHEN("A system throws") {
+			sched.add<reads<velocity>>([](const velocity&) {
+				throw std::runtime_error("nya");
+			});
+			sched.add<reads<health>>([](const health&) {});
+			THEN("The exception reaches the caller") {
+				REQUIRE_THROWS_AS(sched.run(), std::runtime_error);
+			}
+		}
+		THEN("Querying a system that doesn't exist throws") {
+			REQUIRE_THROWS_AS(sched.stage(0), std::out_of_range);
+		}
+	}
+}
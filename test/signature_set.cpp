@@ -0,0 +1,128 @@
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <utility>
+
+#include <ecs.hpp>
+#include <internal/signature_set.hpp>
+
+namespace {
+struct sig_a {
+	int v;
+};
+
+struct sig_b {
+	int v;
+};
+
+/// a family of distinct types, to use more component ids than fit in a word
+template <size_t N>
+struct sig_tag {
+	int v;
+};
+
+template <size_t... N>
+void touch_ids(std::index_sequence<N...>) {
+	(ecs::component_id<sig_tag<N>>(), ...);
+}
+}
+
+TEST_CASE("Signature sets work", "[signature_set]") {
+	using namespace ecs;
+	GIVEN("A signature set") {
+		signature_set s;
+		REQUIRE(!s.test(0, 0));
+		REQUIRE(s.matches(5, {}));
+		WHEN("Low and high component ids are set") {
+			s.set(3, 1);
+			s.set(3, 5);
+			s.set(3, 130);
+			s.set(8, 70);
+			THEN("They are tested per entity") {
+				REQUIRE(s.test(3, 1));
+				REQUIRE(s.test(3, 5));
+				REQUIRE(s.test(3, 130));
+				REQUIRE(!s.test(3, 70));
+				REQUIRE(s.test(8, 70));
+				REQUIRE(!s.test(8, 1));
+				REQUIRE(!s.test(100, 1));
+			}
+			THEN("Masks match on required and excluded ids") {
+				REQUIRE(s.matches(3, { 1, 5 }));
+				REQUIRE(s.matches(3, { 1, 130 }));
+				REQUIRE(!s.matches(3, { 1, 2 }));
+				REQUIRE(!s.matches(3, { 1, 200 }));
+				REQUIRE(!s.matches(3, { 1 }, { 5 }));
+				REQUIRE(!s.matches(3, { 1 }, { 130 }));
+				REQUIRE(s.matches(3, { 1 }, { 70, 200 }));
+				REQUIRE(s.matches(8, { 70 }, { 1 }));
+			}
+			THEN("Widening keeps the bits already set") {
+				s.set(4, 300);
+				REQUIRE(s.test(3, 130));
+				REQUIRE(s.test(8, 70));
+				REQUIRE(s.test(4, 300));
+				REQUIRE(!s.test(3, 300));
+			}
+			THEN("Resetting clears a single id") {
+				s.reset(3, 5);
+				s.reset(3, 130);
+				s.reset(50, 1);
+				REQUIRE(!s.test(3, 5));
+				REQUIRE(!s.test(3, 130));
+				REQUIRE(s.test(3, 1));
+			}
+		}
+	}
+	GIVEN("A registry") {
+		registry reg;
+		auto e = reg.create();
+		e->add<sig_a>(1);
+		e->add<sig_b>(2);
+		const signature_set& s = reg.signatures();
+		THEN("Signatures follow the components added and removed") {
+			REQUIRE(e->has<sig_a, sig_b>());
+			REQUIRE(s.matches(entity_index(e->id()), component_mask::of<sig_a, sig_b>()));
+			e->remove<sig_b>();
+			REQUIRE(!e->has<sig_a, sig_b>());
+			REQUIRE(s.test(entity_index(e->id()), component_id<sig_a>()));
+			REQUIRE(!s.test(entity_index(e->id()), component_id<sig_b>()));
+		}
+		THEN("Removing the entity clears its signature before its index is reused") {
+			size_t idx = entity_index(e->id());
+			reg.remove(e);
+			auto f = reg.create();
+			REQUIRE(entity_index(f->id()) == idx);
+			REQUIRE(!f->has<sig_a, sig_b>());
+			REQUIRE(!s.test(idx, component_id<sig_a>()));
+		}
+		THEN("Clones get the same signature") {
+			auto f = e->clone();
+			REQUIRE(f->has<sig_a, sig_b>());
+		}
+	}
+	GIVEN("Components whose ids don't fit in a word") {
+		touch_ids(std::make_index_sequence<component_mask::WORD_BITS + 1>{});
+		REQUIRE(component_id<sig_tag<component_mask::WORD_BITS>>() >= component_mask::WORD_BITS);
+		registry reg;
+		auto a = reg.create();
+		auto b = reg.create();
+		auto c = reg.create();
+		for (entity_t e : { a, b, c }) {
+			e->add<sig_tag<0>>(1);
+			e->add<sig_tag<component_mask::WORD_BITS>>(2);
+		}
+		b->add<sig_a>(3);
+		c->remove<sig_tag<component_mask::WORD_BITS>>();
+		THEN("Views still match on them") {
+			size_t n = 0;
+			reg.view<sig_tag<0>, sig_tag<component_mask::WORD_BITS>, exclude<sig_a>>().each([&n, &a](entity_t e, auto&, auto&) {
+				n++;
+				REQUIRE(e == a);
+			});
+			REQUIRE(n == 1);
+			REQUIRE(a->has<sig_tag<0>, sig_tag<component_mask::WORD_BITS>>());
+			REQUIRE(!c->has<sig_tag<0>, sig_tag<component_mask::WORD_BITS>>());
+		}
+	}
+}
@@ -0,0 +1,220 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ecs.hpp>
+
+struct snap_position {
+	float x;
+	float y;
+};
+
+struct snap_name {
+	std::string value;
+};
+
+/// a type saved under the name of snap_position, with another layout
+struct snap_wide {
+	double x;
+	double y;
+};
+
+static void save_name(const snap_name& n, std::ostream& out) {
+	size_t len = n.value.size();
+	out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+	out.write(n.value.data(), len);
+}
+
+static snap_name load_name(std::istream& in) {
+	size_t len;
+	in.read(reinterpret_cast<char*>(&len), sizeof(len));
+	std::string value(len, '\0');
+	in.read(value.data(), len);
+	return snap_name{ value };
+}
+
+/// the name of the i-th entity of this test
+static std::string name_of(size_t i) {
+	std::string name = "e";
+	name += std::to_string(i);
+	return name;
+}
+
+/// registers the snapshot types of this test
+static void register_types(ecs::registry& reg) {
+	reg.register_component<snap_position>("position");
+	reg.register_component<snap_name>("name", &save_name, &load_name);
+}
+
+TEST_CASE("Registry snapshots work", "[snapshot]") {
+	using namespace ecs;
+	const std::string path = "ecs-test-snapshot.bin";
+	GIVEN("A registry saved to a snapshot") {
+		std::vector<entity_id> ids;
+		{
+			registry reg;
+			register_types(reg);
+			std::vector<entity_t> ents;
+			reg.create_many(component_pool::PAGE_SZ + 100, std::back_inserter(ents));
+			for (size_t i = 0; i < ents.size(); ++i) {
+				ents[i]->add<snap_position>(float(i), float(i) * 2);
+				if (i % 3 == 0) ents[i]->add<snap_name>(name_of(i));
+			}
+			reg.remove(ents[7]);
+			for (auto& e : ents) {
+				if (e->alive()) ids.push_back(e->id());
+			}
+			reg.save(path);
+		}
+		WHEN("It is loaded into another registry") {
+			registry reg;
+			register_types(reg);
+			reg.load_mapped(path);
+			THEN("Every entity and component is back") {
+				REQUIRE(reg.count() == ids.size());
+				for (entity_id id : ids) {
+					REQUIRE(reg.valid(id));
+					entity_t e	= reg.at(id);
+					size_t i	= entity_index(id);
+					REQUIRE(e->get<snap_position>().x == float(i));
+					REQUIRE(e->get<snap_position>().y == float(i) * 2);
+					REQUIRE(e->has<snap_name>() == (i % 3 == 0));
+					REQUIRE(e->has<snap_position, snap_name>() == (i % 3 == 0));
+					if (i % 3 == 0) {
+						REQUIRE(e->get<snap_name>().value == name_of(i));
+					}
+				}
+			}
+			THEN("Removed ids are still recycled with a new generation") {
+				entity_t e = reg.create();
+				REQUIRE(entity_index(e.id()) == 7);
+				REQUIRE(entity_generation(e.id()) == 1);
+			}
+			THEN("Mapped components can be modified, removed and added to") {
+				entity_t e = reg.at(ids[0]);
+				e->get<snap_position>().x = 42;
+				e->remove<snap_position>();
+				reg.at(ids[3])->remove<snap_name>();
+				e->add<snap_position>(1.f, 2.f);
+				for (size_t i = 0; i < component_pool::PAGE_SZ * 2; ++i) {
+					reg.create()->add<snap_position>(0.f, 0.f);
+				}
+				REQUIRE(e->get<snap_position>().y == 2.f);
+				REQUIRE(reg.at(ids.back())->get<snap_position>().x == float(entity_index(ids.back())));
+			}
+		}
+		WHEN("It is loaded into a registry with a cached query") {
+			registry reg;
+			register_types(reg);
+			auto q = reg.query<snap_position, snap_name>();
+			reg.load_mapped(path);
+			THEN("The query caches the loaded entities") {
+				size_t named = std::count_if(ids.begin(), ids.end(), [](entity_id id) {
+					return entity_index(id) % 3 == 0;
+				});
+				REQUIRE(q.size() == named);
+				q.each([](entity_t e, snap_position& p, snap_name& n) {
+					REQUIRE(n.value == name_of(entity_index(e.id())));
+				});
+			}
+		}
+		WHEN("It is loaded into a registry missing a type") {
+			registry reg;
+			reg.register_component<snap_position>("position");
+			THEN("Nothing is loaded") {
+				REQUIRE_THROWS_AS(reg.load_mapped(path), std::runtime_error);
+				REQUIRE(reg.count() == 0);
+			}
+		}
+		WHEN("It is loaded into a registry with another layout for a type") {
+			registry reg;
+			reg.register_component<snap_wide>("position");
+			reg.register_component<snap_name>("name", &save_name, &load_name);
+			THEN("Nothing is loaded, and no pool is constructed") {
+				REQUIRE_THROWS_AS(reg.load_mapped(path), std::runtime_error);
+				REQUIRE(reg.count() == 0);
+				REQUIRE(reg.find_pool<snap_wide>() == nullptr);
+				REQUIRE(reg.find_pool<snap_name>() == nullptr);
+			}
+		}
+		WHEN("Its entity count is corrupted to wrap around once multiplied") {
+			// the entity count follows the magic, 4 header words and the next index
+			std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+			uint64_t huge = (uint64_t(1) << 61) + 1;
+			file.seekp(4 + 4 * sizeof(uint32_t) + sizeof(uint64_t));
+			file.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+			file.close();
+			registry reg;
+			register_types(reg);
+			THEN("It can't be loaded") {
+				REQUIRE_THROWS_AS(reg.load_mapped(path), std::runtime_error);
+				REQUIRE(reg.count() == 0);
+			}
+		}
+		WHEN("A pool lists an entity missing from the snapshot") {
+			std::string bytes;
+			{
+				std::ifstream in(path, std::ios::binary);
+				bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			}
+			// the name is followed by the raw flag, the count, then the entities aligned to 8 bytes
+			size_t name = bytes.find("position");
+			REQUIRE(name != std::string::npos);
+			size_t ents = (name + 8 + sizeof(uint32_t) + sizeof(uint64_t) + 7) / 8 * 8;
+			std::fill_n(bytes.begin() + ents, sizeof(entity_id), '\xff');
+			{
+				std::ofstream out(path, std::ios::binary | std::ios::trunc);
+				out.write(bytes.data(), bytes.size());
+			}
+			registry reg;
+			register_types(reg);
+			THEN("Nothing is loaded, and no pool is constructed") {
+				REQUIRE_THROWS_AS(reg.load_mapped(path), std::runtime_error);
+				REQUIRE(reg.count() == 0);
+				REQUIRE(reg.find_pool<snap_position>() == nullptr);
+			}
+		}
+		WHEN("It is loaded into a registry that isn't empty") {
+			registry reg;
+			register_types(reg);
+			reg.create();
+			THEN("It throws") {
+				REQUIRE_THROWS_AS(reg.load_mapped(path), std::runtime_error);
+			}
+		}
+		std::remove(path.c_str());
+	}
+	GIVEN("A registry with a component not registered for snapshots") {
+		registry reg;
+		reg.create()->add<snap_name>("x");
+		THEN("It can't be saved") {
+			REQUIRE_THROWS_AS(reg.save(path), std::runtime_error);
+		}
+		std::remove(path.c_str());
+	}
+	GIVEN("A file that isn't a snapshot") {
+		{
+			std::ofstream out(path, std::ios::binary);
+			out << "definitely not a snapshot";
+		}
+		registry reg;
+		THEN("It can't be loaded") {
+			REQUIRE_THROWS_AS(reg.load_mapped(path), std::runtime_error);
+		}
+		std::remove(path.c_str());
+	}
+	THEN("Two types can't share a name") {
+		registry reg;
+		reg.register_component<snap_position>("position");
+		REQUIRE_THROWS_AS(reg.register_component<snap_name>("position", &save_name, &load_name), std::runtime_error);
+	}
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <ecs.hpp>
+
+namespace {
+struct body {
+	float x;
+	float y;
+	double mass;
+	int id;
+};
+}
+
+template <>
+struct ecs::soa_layout<body> : ecs::soa_fields<&body::x, &body::y, &body::mass, &body::id> {};
+
+namespace {
+struct tag {
+	int id;
+};
+}
+
+TEST_CASE("Structure of arrays storage works.", "[soa]") {
+	using namespace ecs;
+	static_assert(soa_layout<body>::index_of<&body::mass>() == 2);
+	static_assert(std::is_same_v<component_ref_t<body>, soa_ref<body>>);
+	static_assert(std::is_same_v<component_ref_t<tag>, tag&>);
+	GIVEN("Some entities with a component stored as a structure of arrays") {
+		registry reg;
+		std::vector<entity_t> ents;
+		for (int i = 0; i < 3000; ++i) {
+			auto e = reg.create();
+			e->add<body>(float(i), float(2 * i), 1.5, i);
+			if (i % 2 == 0) e->add<tag>(i);
+			ents.push_back(e);
+		}
+		THEN("Each field sits in its own array") {
+			const component_pool& p = reg.pool(typeid(body));
+			REQUIRE(p.soa());
+			REQUIRE(p.field(0, 1) - p.field(0, 0) == sizeof(float));
+			REQUIRE(p.field(2, 1) - p.field(2, 0) == sizeof(double));
+			REQUIRE(reinterpret_cast<std::uintptr_t>(p.field(2, 0)) % component_pool::PAGE_ALIGN == 0);
+		}
+		THEN("Components can be read and written through their entity") {
+			soa_ref<body> b = ents[7]->get<body>();
+			REQUIRE(b.get<&body::x>() == 7.f);
+			REQUIRE(b.get<&body::id>() == 7);
+			b.get<&body::y>() = 42.f;
+			body whole = ents[7]->get<body>();
+			REQUIRE(whole.y == 42.f);
+			REQUIRE(whole.mass == 1.5);
+			ents[7]->get<body>() = body{ 1.f, 2.f, 3.0, 4 };
+			const entity_t& ce = ents[7];
+			REQUIRE(ce->get<body>().get<&body::mass>() == 3.0);
+		}
+		THEN("Views hand out references to each component") {
+			size_t n = 0;
+			reg.view<body, tag>().each([&n](soa_ref<body> b, tag& t) {
+				REQUIRE(b.get<&body::id>() == t.id);
+				b.get<&body::x>() += 1.f;
+				n++;
+			});
+			REQUIRE(n == 1500);
+			REQUIRE(ents[2]->get<body>().get<&body::x>() == 3.f);
+			REQUIRE(ents[3]->get<body>().get<&body::x>() == 3.f);
+			for (auto [b, t] : reg.view<body, tag>()) {
+				REQUIRE(b.get<&body::id>() == t.id);
+			}
+		}
+		THEN("Chunked iteration hands out a span per field") {
+			size_t n = 0;
+			reg.view<body>().each_chunk([&n](std::span<const entity_id> ids, soa_span<body> bs) {
+				std::span<float> xs		   = bs.get<&body::x>();
+				std::span<const float> ys = bs.get<&body::y>();
+				REQUIRE(xs.size() == ids.size());
+				for (size_t i = 0; i < xs.size(); ++i) {
+					xs[i] += ys[i];
+				}
+				n += bs.size();
+			});
+			REQUIRE(n == 3000);
+			REQUIRE(ents[10]->get<body>().get<&body::x>() == 30.f);
+		}
+		WHEN("Components are removed and groups reorder the pool") {
+			for (int i = 0; i < 3000; i += 3) {
+				ents[i]->remove<body>();
+			}
+			auto g = reg.group<body, tag>();
+			THEN("Every field moves along with its component") {
+				for (int i = 0; i < 3000; ++i) {
+					if (i % 3 == 0) continue;
+					body b = ents[i]->get<body>();
+					REQUIRE(b.x == float(i));
+					REQUIRE(b.y == float(2 * i));
+					REQUIRE(b.id == i);
+				}
+				size_t n = 0;
+				g.each([&n](soa_ref<const body> b, const tag& t) {
+					REQUIRE(b.get<&body::id>() == t.id);
+					n++;
+				});
+				REQUIRE(n == 1000);
+			}
+		}
+		THEN("Systems can declare access to them") {
+			scheduler sched(reg);
+			sched.add<reads<body>, writes<tag>>([](soa_ref<const body> b, tag& t) {
+				t.id = b.get<&body::id>() * 2;
+			});
+			sched.run();
+			REQUIRE(ents[4]->get<tag>().id == 8);
+		}
+		THEN("Cloning copies every field") {
+			auto c = ents[5]->clone();
+			body b = c->get<body>();
+			REQUIRE(b.x == 5.f);
+			REQUIRE(b.id == 5);
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#include <catch2/catch.hpp>
+
+#include <internal/sparse_set.hpp>
+
+TEST_CASE("Sparse sets work", "[sparse_set]") {
+	using namespace ecs;
+	GIVEN("A sparse set") {
+		sparse_set s;
+		REQUIRE(s.size() == 0);
+		REQUIRE(!s.contains(0));
+		WHEN("Ids are inserted") {
+			REQUIRE(s.insert(10) == 0);
+			REQUIRE(s.insert(2) == 1);
+			REQUIRE(s.insert(5) == 2);
+			THEN("They are contained") {
+				REQUIRE(s.contains(10));
+				REQUIRE(s.contains(2));
+				REQUIRE(s.contains(5));
+				REQUIRE(!s.contains(3));
+				REQUIRE(!s.contains(100));
+				REQUIRE(s.size() == 3);
+			}
+			THEN("Inserting twice throws") {
+				REQUIRE_THROWS(s.insert(2));
+			}
+			THEN("Removing keeps the dense array packed") {
+				s.remove(10);
+				REQUIRE(!s.contains(10));
+				REQUIRE(s.size() == 2);
+				REQUIRE(s.dense()[0] == 5);
+				REQUIRE(s.dense()[1] == 2);
+				REQUIRE(s.index(5) == 0);
+				REQUIRE(s.index(2) == 1);
+				REQUIRE_THROWS(s.remove(10));
+				REQUIRE_THROWS(s.index(10));
+			}
+			THEN("Removing the last id works") {
+				s.remove(5);
+				REQUIRE(s.size() == 2);
+				REQUIRE(s.index(10) == 0);
+				REQUIRE(s.index(2) == 1);
+			}
+		}
+		WHEN("An id with another generation is tested") {
+			s.insert(make_entity_id(3, 0));
+			THEN("It is not contained") {
+				REQUIRE(s.contains(make_entity_id(3, 0)));
+				REQUIRE(!s.contains(make_entity_id(3, 1)));
+				REQUIRE_THROWS(s.insert(make_entity_id(3, 1)));
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <internal/thread_pool.hpp>
+
+TEST_CASE("Thread pools work", "[thread_pool]") {
+	using namespace ecs;
+	GIVEN("A thread pool") {
+		thread_pool pool(4);
+		REQUIRE(pool.size() == 4);
+		WHEN("A batch is run") {
+			std::vector<int> hits(1000, 0);
+			pool.run(hits.size(), [&hits](size_t i) {
+				hits[i]++;
+			});
+			THEN("Every task runs exactly once") {
+				for (int h : hits) {
+					REQUIRE(h == 1);
+				}
+			}
+		}
+		WHEN("A batch is run from within a task") {
+			std::atomic<size_t> count(0);
+			pool.run(8, [&pool, &count](size_t) {
+				pool.run(16, [&count](size_t) {
+					count++;
+				});
+			});
+			THEN("Every nested task runs") {
+				REQUIRE(count == 8 * 16);
+			}
+		}
+		WHEN("A task throws") {
+			THEN("The exception reaches the caller") {
+				auto task = [](size_t i) {
+					if (i == 7) throw std::runtime_error("nya");
+				};
+				REQUIRE_THROWS_AS(pool.run(10, task), std::runtime_error);
+			}
+			THEN("The pool is still usable") {
+				std::atomic<size_t> count(0);
+				pool.run(10, [&count](size_t) {
+					count++;
+				});
+				REQUIRE(count == 10);
+			}
+		}
+	}
+}
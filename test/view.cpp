@@ -1,5 +1,13 @@
 #include <catch2/catch.hpp>
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <vector>
+
 #include <ecs.hpp>
 
 struct position {
@@ -28,7 +36,7 @@ TEST_CASE("Viewing components works.") {
 		e2->add<color>(.2f, .2f, .8f);
 		REQUIRE(e2->get<color>().g == .2f);
 		WHEN("We use a ranged-based for loop over a view of one component") {
-			for (auto& [col] : reg.view<color>()) {
+			for (auto [col] : reg.view<color>()) {
 				THEN("We can retrieve the entity") {
 					REQUIRE(col.r == 0.2f);
 				}
@@ -36,7 +44,7 @@ TEST_CASE("Viewing components works.") {
 		}
 		WHEN("We try fetching a component that doesn't exist") {
 			THEN("A ranged based for loop never runs.") {
-				for (auto& [_] : reg.view<unused>()) {
+				for ([[maybe_unused]] auto [_] : reg.view<unused>()) {
 					REQUIRE(false);
 				}
 			}
@@ -121,6 +129,24 @@ TEST_CASE("Viewing components works.") {
 				REQUIRE(e2->get<position>().x == 9);
 				REQUIRE(e2->get<position>().y == 10);
 			}
+			THEN("We can iterate over it using any callable") {
+				struct counter {
+					int calls = 0;
+					void operator()(entity_t e, position& p, color& c) {
+						REQUIRE(e->has<position, color>());
+						calls++;
+					}
+				} fn;
+				v.each(fn);
+				REQUIRE(fn.calls == 1);
+				int calls = 0;
+				v.each([&calls](auto& p, auto& c) {
+					p.x++;
+					calls++;
+				});
+				REQUIRE(calls == 1);
+				REQUIRE(e2->get<position>().x == 9);
+			}
 			THEN("We can iterate over it using const") {
 				int calls = 0;
 				v.each([&calls](const position& p, const color& c) {
@@ -133,5 +159,167 @@ TEST_CASE("Viewing components works.") {
 				REQUIRE(e2->get<position>().y == 9);
 			}
 		}
+		WHEN("One component is much rarer than the other") {
+			std::vector<entity_t> burning;
+			for (int i = 0; i < 100; ++i) {
+				auto e = reg.create();
+				e->add<position>(i, i);
+				if (i % 10 == 0) {
+					e->add<color>(.1f, .1f, .1f);
+					burning.push_back(e);
+				}
+			}
+			view v = reg.view<position, color>();
+			THEN("The rare component's pool drives the iteration") {
+				std::pmr::vector<entity_id> visited;
+				v.each([&visited](entity_t e, position& p, color& c) {
+					visited.push_back(e->id());
+				});
+				const std::pmr::vector<entity_id>& colors = reg.pool(typeid(color)).entities();
+				REQUIRE(visited == colors);
+				size_t count = 0;
+				for ([[maybe_unused]] auto [p, c] : v) {
+					count++;
+				}
+				// e2 has both components too
+				REQUIRE(count == burning.size() + 1);
+			}
+		}
+		WHEN("We iterate in parallel") {
+			for (int i = 0; i < 10000; ++i) {
+				auto e = reg.create();
+				e->add<position>(i, 0);
+				if (i % 2 == 0) e->add<color>(.1f, .1f, .1f);
+			}
+			reg.use_workers(std::make_shared<thread_pool>(4));
+			THEN("Every matching entity is visited once") {
+				reg.view<position>().par_each([](position& p) { p.y++; }, { .grain = 64 });
+				int calls = 0;
+				reg.view<position>().each([&calls](position& p) {
+					REQUIRE(p.y >= 1);
+					calls++;
+				});
+				REQUIRE(calls == 10002);
+				REQUIRE(e1->get<position>().y == 5);
+			}
+			THEN("Multiple component views filter the same way as each()") {
+				std::atomic<int> calls(0);
+				auto count = [&calls](entity_t e, position& p, color& c) { calls++; };
+				reg.view<position, color>().par_each(count, { .grain = 100 });
+				REQUIRE(calls == 5000 + 1);
+			}
+			THEN("Small views run inline") {
+				std::atomic<int> calls(0);
+				reg.view<position>().par_each([&calls](position& p) { calls++; }, { .grain = 1000000 });
+				REQUIRE(calls == 10002);
+			}
+		}
+		WHEN("We iterate in chunks") {
+			for (int i = 0; i < 5000; ++i) {
+				auto e = reg.create();
+				e->add<position>(i, 0);
+				if (i % 7 != 0) e->add<color>(.1f, .1f, .1f);
+			}
+			THEN("A view of one component yields page-sized aligned spans") {
+				size_t total = 0;
+				reg.view<position>().each_chunk([&total](std::span<const entity_id> ids, std::span<position> ps) {
+					REQUIRE(ids.size() == ps.size());
+					REQUIRE(ps.size() <= component_pool::PAGE_SZ);
+					REQUIRE(reinterpret_cast<std::uintptr_t>(ps.data()) % component_pool::PAGE_ALIGN == 0);
+					for (position& p : ps) {
+						p.y += 1;
+					}
+					total += ps.size();
+				});
+				REQUIRE(total == 5002);
+				REQUIRE(e1->get<position>().y == 5);
+			}
+			THEN("A view of many components yields the same entities as each()") {
+				std::vector<entity_id> expected;
+				reg.view<position, color>().each([&expected](entity_t e, position&, color&) {
+					expected.push_back(e->id());
+				});
+				std::vector<entity_id> chunked;
+				const registry& creg = reg;
+				creg.view<position, color>().each_chunk([&chunked, &reg](std::span<const entity_id> ids, std::span<const position> ps, std::span<const color> cs) {
+					REQUIRE(ids.size() == ps.size());
+					REQUIRE(ids.size() == cs.size());
+					for (size_t i = 0; i < ids.size(); ++i) {
+						REQUIRE(&ps[i] == &reg.at(ids[i])->get<position>());
+						REQUIRE(&cs[i] == &reg.at(ids[i])->get<color>());
+					}
+					chunked.insert(chunked.end(), ids.begin(), ids.end());
+				});
+				REQUIRE(chunked == expected);
+			}
+		}
+	}
+}
+
+struct frozen {
+	bool yes;
+};
+
+TEST_CASE("Views exclude and optionally fetch components.") {
+	using namespace ecs;
+	GIVEN("Entities with and without the extra components") {
+		registry reg;
+		std::vector<entity_t> ents;
+		reg.create_many(6, std::back_inserter(ents));
+		for (size_t i = 0; i < ents.size(); ++i) {
+			ents[i]->add<position>(int(i), 0);
+			if (i % 2 == 0) ents[i]->add<frozen>(true);
+			if (i % 3 == 0) ents[i]->add<color>(1.f, 0.f, 0.f);
+		}
+		WHEN("Excluding a component") {
+			std::vector<entity_id> ids;
+			reg.view<position, exclude<frozen>>().each([&ids](entity_t e, position&) {
+				ids.push_back(e.id());
+			});
+			THEN("Entities having it are skipped") {
+				REQUIRE(ids == std::vector<entity_id>{ ents[1].id(), ents[3].id(), ents[5].id() });
+			}
+			THEN("Iterators skip them too") {
+				size_t n = 0;
+				for (auto [p] : reg.view<position, exclude<frozen, unused>>()) {
+					REQUIRE(p.x % 2 == 1);
+					n++;
+				}
+				REQUIRE(n == 3);
+			}
+			THEN("Runs of chunks break around them") {
+				size_t n = 0;
+				reg.view<position, exclude<frozen>>().each_chunk([&n](std::span<position> p) {
+					REQUIRE(p.size() == 1);
+					n += p.size();
+				});
+				REQUIRE(n == 3);
+			}
+		}
+		WHEN("Fetching an optional component") {
+			int with = 0, without = 0;
+			reg.view<position, optional<color, unused>>().each([&](position& p, color* c, unused* u) {
+				REQUIRE(u == nullptr);
+				if (c) {
+					REQUIRE(p.x % 3 == 0);
+					with++;
+				} else {
+					without++;
+				}
+			});
+			THEN("It is given when present") {
+				REQUIRE(with == 2);
+				REQUIRE(without == 4);
+			}
+			THEN("Const iterators hand it out as a const pointer") {
+				const registry& cr = reg;
+				int n = 0;
+				for (auto [p, c] : cr.view<position, exclude<frozen>, optional<color>>()) {
+					static_assert(std::is_same_v<decltype(c), const color*>);
+					n += c != nullptr;
+				}
+				REQUIRE(n == 1);
+			}
+		}
 	}
 }
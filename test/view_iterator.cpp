@@ -1,5 +1,8 @@
 #include <catch2/catch.hpp>
+#include <algorithm>
+#include <execution>
 #include <iostream>
+#include <ranges>
 
 #include <ecs.hpp>
 
@@ -11,6 +14,12 @@ struct damage {
 	int x;
 };
 
+static_assert(std::ranges::random_access_range<ecs::view<health>>);
+static_assert(std::ranges::random_access_range<const ecs::view<health>>);
+static_assert(std::ranges::forward_range<ecs::view<health, damage>>);
+static_assert(std::ranges::forward_range<const ecs::view<health, damage>>);
+static_assert(!std::ranges::bidirectional_range<ecs::view<health, damage>>);
+
 TEST_CASE("View iterators work.") {
 	using namespace ecs;
 	GIVEN("Some entities") {
@@ -33,7 +42,7 @@ TEST_CASE("View iterators work.") {
 			}
 			THEN("Iterating over lets us change the values") {
 				int count = 0;
-				for (auto& [health] : v) {
+				for (auto [health] : v) {
 					count++;
 					health.x++;
 				}
@@ -48,13 +57,36 @@ TEST_CASE("View iterators work.") {
 			view v = reg.view<health, damage>();
 			THEN("We can iterate over it using a for range.") {
 				int count = 0;
-				for (auto& [health, damage] : v) {
+				for (auto [health, damage] : v) {
 					count++;
 					REQUIRE(health.x == 5);
 					REQUIRE(damage.x == 3);
 				}
 				REQUIRE(count == 4);
 			}
+			THEN("We can use standard algorithms on it") {
+				REQUIRE(std::ranges::distance(v) == 4);
+				REQUIRE(std::ranges::all_of(v, [](auto t) { return std::get<0>(t).x == 5; }));
+			}
+		}
+		WHEN("We use a parallel algorithm over a view of one component") {
+			view v = reg.view<health>();
+			std::for_each(std::execution::par_unseq, v.begin(), v.end(), [](auto t) {
+				std::get<0>(t).x *= 2;
+			});
+			THEN("Every component is visited") {
+				REQUIRE(e1->get<health>().x == 10);
+				REQUIRE(e2->get<health>().x == 10);
+				REQUIRE(e3->get<health>().x == 10);
+				REQUIRE(e4->get<health>().x == 10);
+			}
+			THEN("Iterators can jump") {
+				auto it = v.begin();
+				REQUIRE(v.end() - it == 4);
+				REQUIRE(std::get<0>(it[3]).x == 10);
+				REQUIRE(it + 4 == v.end());
+				REQUIRE(it < v.end());
+			}
 		}
 	}
 }